@@ -1,6 +1,19 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <new>
+#include <chrono>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
@@ -10,20 +23,27 @@ namespace fft {
 
 // DFT uses FFT over the field of complex numbers.
 // NTT uses FFT over the field of numbers modulo 2013265921.
+// MultiModConvolution combines three NTTs for exact results up to about
+// 10^25, or results modulo any mod below 2^31 (such as 10^9+7).
 
 // How to use: 
 // 1. Instantiate an object of class DFT or NTT.
 // convolution::DFT dft;
 // 2. Call the convolute method on two std::vectors a and b.
 // auto c = dft.convolute(a, b);
+// For repeated convolutions without allocations, use a Plan instead.
 
 // In the case of DFT, the types can be double, int or int64.
 // In the case of NTT, the types can be int, int64 or unsigned int.
 
 // DFT is faster and works on larger numbers, but may have precision issues.
+// For real inputs DFT packs both operands into a single complex transform,
+// so a convolution costs two FFTs instead of three.
 // NTT should only be used when the inputs and outputs fit in the range
 // [-10^9, 10^9] for int or int64, or [0, 2*10^9] for unsigned in.
 // The array sizes for NTT should be at most 2^26.
+// On x86-64 CPUs with AVX2 the transforms use vectorized butterflies,
+// picked at runtime; other CPUs take the scalar path.
 
 typedef long long int64;
 
@@ -51,6 +71,10 @@ public:
         return Complex(a / len, -b / len);
     }
 
+    Complex conj() const {
+        return Complex(a, -b);
+    }
+
     static Complex root(int lgsz, int kth=1) {
         return Complex(cos(2*pi*kth / (1<<lgsz)), sin(2*pi*kth / (1<<lgsz)));
     }
@@ -61,6 +85,25 @@ ostream& operator << (ostream& out, const Complex& c) {
     return out;
 }
 
+// Fills roots[m + t] = w_m^t for every power of two m in [from, to).
+// Each level is derived from the previous one with a single long double
+// root, which keeps the error far below that of repeated multiplication
+// and avoids a cos/sin call per root.
+void fillRoots(Complex* roots, int from, int to) {
+    for (int m = from; m < to; m <<= 1) {
+        long double ang = 2 * acosl(-1) / m;
+        long double c = cosl(ang), s = sinl(ang);
+        for (int t = 0; t < m; ++t) {
+            const Complex& half = roots[(m>>1) + (t>>1)];
+            if (t & 1) {
+                roots[m + t] = Complex(half.a * c - half.b * s, half.a * s + half.b * c);
+            } else {
+                roots[m + t] = half;
+            }
+        }
+    }
+}
+
 void assign(double& d, const Complex& c) {
     d = c.a;
 }
@@ -81,10 +124,36 @@ void assign(int& i, const Complex& c) {
     i = myRound(c.a);
 }
 
-class Modular {
+// Returns -mod^-1 modulo 2^32, for odd mod.
+constexpr uint32_t negInverse(uint32_t mod) {
+    uint32_t inv = mod;
+    for (int i = 0; i < 4; ++i)
+        inv *= 2 - mod * inv;
+    return -inv;
+}
+
+// Field of integers modulo a prime mod = k * 2^lgMax + 1 < 2^31, with
+// generator g. Values are kept in Montgomery form (x * 2^32 mod mod) in
+// 32 bits, so a product is reduced with two multiplications instead of
+// a division.
+template<uint32_t M, uint32_t G>
+class ModularField {
+    typedef ModularField<M, G> Self;
+
+    static constexpr int twoAdicity() {
+        int lg = 0;
+        while (((M - 1) >> lg & 1) == 0)
+            ++lg;
+        return lg;
+    }
+
   public:
-    static const int64 mod = 2013265921;
-    static const int64 r = 137;
+    static constexpr uint32_t mod = M;
+    static constexpr int lgMax = twoAdicity();
+    // -mod^-1 modulo 2^32 and 2^64 modulo mod.
+    static constexpr uint32_t modInv = negInverse(M);
+    static constexpr uint32_t r2 = (-(uint64_t)M) % M;
+
     static int64 lgpow(int64 x, int64 pw) {
         if (pw == 0)
             return 1;
@@ -93,76 +162,437 @@ class Modular {
             return x2*x2%mod*x%mod;
         return x2*x2%mod;
     }
-    int64 x;
 
-    Modular(int64 x=0) {
-        if (x >= mod || x <= -mod)
-            x %= mod;
-        this->x = x;
+    // Returns t * 2^-32 modulo mod, for t < mod * 2^32.
+    static uint32_t reduce(uint64_t t) {
+        uint32_t m = (uint32_t)t * modInv;
+        uint32_t u = (t + (uint64_t)m * mod) >> 32;
+        return u >= mod ? u - mod : u;
+    }
+
+    static Self raw(uint32_t x) {
+        Self m;
+        m.x = x;
+        return m;
+    }
+
+    uint32_t x;
+
+    ModularField(int64 x=0) {
+        x %= (int64)mod;
+        if (x < 0)
+            x += mod;
+        this->x = reduce((uint64_t)x * r2);
     }
 
-    Modular operator + (const Modular& other) const {
-        int64 s = x + other.x;
+    // The value in [0, mod).
+    uint32_t value() const {
+        return reduce(x);
+    }
+
+    Self operator + (const Self& other) const {
+        uint32_t s = x + other.x;
         if (s >= mod)
             s -= mod;
-        return Modular(s);
+        return raw(s);
     }
 
-    Modular operator - (const Modular& other) const {
-        int64 d = x - other.x;
-        if (d <= -mod)
+    Self operator - (const Self& other) const {
+        uint32_t d = x - other.x;
+        if (x < other.x)
             d += mod;
-        return Modular(d);
+        return raw(d);
     }
 
-    Modular operator * (const Modular& other) const {
-        return Modular(x * other.x % mod);
+    Self operator * (const Self& other) const {
+        return raw(reduce((uint64_t)x * other.x));
     }
 
-    Modular inverse() {
-        return Modular(lgpow(x, mod-2));
+    Self inverse() const {
+        return Self(lgpow(value(), mod-2));
     }
 
-    static Modular root(int lgsz, int kth=1) {
-        return Modular(lgpow(lgpow(r, 1<<(27-lgsz)), kth));
+    static Self root(int lgsz, int kth=1) {
+        return Self(lgpow(lgpow(G, (mod - 1) >> lgsz), kth));
     }
 };
 
-ostream& operator << (ostream& out, const Modular& m) {
-    out << m.x;
+template<uint32_t M, uint32_t G>
+void fillRoots(ModularField<M, G>* roots, int from, int to) {
+    for (int m = from; m < to; m <<= 1) {
+        int lgm = 0;
+        while ((1<<lgm) < m)
+            ++lgm;
+        auto w = ModularField<M, G>::root(lgm);
+        for (int t = 0; t < m; ++t) {
+            const auto& half = roots[(m>>1) + (t>>1)];
+            roots[m + t] = (t & 1 ? half * w : half);
+        }
+    }
+}
+
+template<uint32_t M, uint32_t G>
+ostream& operator << (ostream& out, const ModularField<M, G>& m) {
+    out << m.value();
     return out;
 }
 
-void assign(int64& i, const Modular& m) {
-    auto t = m.x;
-    if (t < 0)
-        t += Modular::mod;
-    i = t;
-    if (t >= (Modular::mod>>1))
-        i = -(Modular::mod - t);
+template<uint32_t M, uint32_t G>
+void assign(ModularField<M, G>& myM, const ModularField<M, G>& m) {
+    myM = m;
 }
 
-void assign(int& i, const Modular& m) {
-	auto t = m.x;
-    if (t < 0)
-        t += Modular::mod;
+template<uint32_t M, uint32_t G>
+void assign(int64& i, const ModularField<M, G>& m) {
+    int64 t = m.value();
     i = t;
-    if (t >= (Modular::mod>>1))
-        i = -(Modular::mod - t);
+    if (t >= (M>>1))
+        i = -(M - t);
 }
 
-void assign(unsigned int& i, const Modular& m) {
-    auto t = m.x;
-    if (t < 0)
-        t += Modular::mod;
+template<uint32_t M, uint32_t G>
+void assign(int& i, const ModularField<M, G>& m) {
+    int64 t = m.value();
     i = t;
+    if (t >= (M>>1))
+        i = -(M - t);
+}
+
+template<uint32_t M, uint32_t G>
+void assign(unsigned int& i, const ModularField<M, G>& m) {
+    i = m.value();
+}
+
+typedef ModularField<2013265921, 31> Modular;
+
+// AVX2 radix-4 passes, used when the CPU supports them.
+// Each call does the same work as one scalar radix-4 pass in
+// Convolution::dit or Convolution::dif, several butterflies at a time.
+namespace simd {
+
+#if defined(__x86_64__)
+bool enabled() {
+    static const bool ok = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return ok;
+}
+
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+
+// Two complex numbers per register, as (re, im, re, im).
+inline __m256d mul(__m256d x, __m256d w) {
+    __m256d wre = _mm256_movedup_pd(w);
+    __m256d wim = _mm256_permute_pd(w, 0xF);
+    __m256d xs = _mm256_permute_pd(x, 0x5);
+    return _mm256_fmaddsub_pd(x, wre, _mm256_mul_pd(xs, wim));
+}
+
+// Needs width to be a multiple of 2.
+void radix4(Complex* c, const Complex* r, int sz, int h, int width, bool dif) {
+    double* d = reinterpret_cast<double*>(c);
+    const double* w = reinterpret_cast<const double*>(r);
+    for (int start = 0; start < sz; start += (h<<2)) {
+        for (int i = 0; i < width; i += 2) {
+            double* p = d + 2*(start + i);
+            __m256d w1 = _mm256_loadu_pd(w + 2*(i + 2*h));
+            __m256d w2 = _mm256_loadu_pd(w + 2*(i + 4*h));
+            __m256d w3 = _mm256_loadu_pd(w + 2*(i + 5*h));
+            __m256d a0 = _mm256_loadu_pd(p);
+            __m256d a1 = _mm256_loadu_pd(p + 2*h);
+            __m256d a2 = _mm256_loadu_pd(p + 4*h);
+            __m256d a3 = _mm256_loadu_pd(p + 6*h);
+            if (dif) {
+                __m256d b0 = _mm256_add_pd(a0, a2);
+                __m256d b2 = mul(_mm256_sub_pd(a0, a2), w2);
+                __m256d b1 = _mm256_add_pd(a1, a3);
+                __m256d b3 = mul(_mm256_sub_pd(a1, a3), w3);
+                _mm256_storeu_pd(p, _mm256_add_pd(b0, b1));
+                _mm256_storeu_pd(p + 2*h, mul(_mm256_sub_pd(b0, b1), w1));
+                _mm256_storeu_pd(p + 4*h, _mm256_add_pd(b2, b3));
+                _mm256_storeu_pd(p + 6*h, mul(_mm256_sub_pd(b2, b3), w1));
+            } else {
+                a1 = mul(a1, w1);
+                a3 = mul(a3, w1);
+                __m256d b0 = _mm256_add_pd(a0, a1), b1 = _mm256_sub_pd(a0, a1);
+                __m256d b2 = mul(_mm256_add_pd(a2, a3), w2);
+                __m256d b3 = mul(_mm256_sub_pd(a2, a3), w3);
+                _mm256_storeu_pd(p, _mm256_add_pd(b0, b2));
+                _mm256_storeu_pd(p + 4*h, _mm256_sub_pd(b0, b2));
+                _mm256_storeu_pd(p + 2*h, _mm256_add_pd(b1, b3));
+                _mm256_storeu_pd(p + 6*h, _mm256_sub_pd(b1, b3));
+            }
+        }
+    }
+}
+
+// Eight Montgomery-form residues per register.
+// mod and modInv are broadcast to every 32-bit lane.
+inline __m256i mul(__m256i a, __m256i b, __m256i mod, __m256i modInv) {
+    __m256i tEven = _mm256_mul_epu32(a, b);
+    __m256i tOdd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    __m256i uEven = _mm256_add_epi64(tEven,
+        _mm256_mul_epu32(_mm256_mul_epu32(tEven, modInv), mod));
+    __m256i uOdd = _mm256_add_epi64(tOdd,
+        _mm256_mul_epu32(_mm256_mul_epu32(tOdd, modInv), mod));
+    __m256i u = _mm256_blend_epi32(_mm256_srli_epi64(uEven, 32), uOdd, 0xAA);
+    return _mm256_min_epu32(u, _mm256_sub_epi32(u, mod));
+}
+
+inline __m256i add(__m256i a, __m256i b, __m256i mod) {
+    __m256i s = _mm256_add_epi32(a, b);
+    return _mm256_min_epu32(s, _mm256_sub_epi32(s, mod));
+}
+
+inline __m256i sub(__m256i a, __m256i b, __m256i mod) {
+    __m256i d = _mm256_sub_epi32(a, b);
+    return _mm256_min_epu32(d, _mm256_add_epi32(d, mod));
+}
+
+// Needs width to be a multiple of 8 and mod < 2^31.
+void radix4(uint32_t* c, const uint32_t* r, int sz, int h, int width, bool dif,
+    uint32_t modulus, uint32_t inverse) {
+    __m256i mod = _mm256_set1_epi32(modulus);
+    __m256i modInv = _mm256_set1_epi32(inverse);
+    for (int start = 0; start < sz; start += (h<<2)) {
+        for (int i = 0; i < width; i += 8) {
+            uint32_t* p = c + start + i;
+            __m256i w1 = _mm256_loadu_si256((const __m256i*)(r + i + 2*h));
+            __m256i w2 = _mm256_loadu_si256((const __m256i*)(r + i + 4*h));
+            __m256i w3 = _mm256_loadu_si256((const __m256i*)(r + i + 5*h));
+            __m256i a0 = _mm256_loadu_si256((const __m256i*)p);
+            __m256i a1 = _mm256_loadu_si256((const __m256i*)(p + h));
+            __m256i a2 = _mm256_loadu_si256((const __m256i*)(p + 2*h));
+            __m256i a3 = _mm256_loadu_si256((const __m256i*)(p + 3*h));
+            if (dif) {
+                __m256i b0 = add(a0, a2, mod);
+                __m256i b2 = mul(sub(a0, a2, mod), w2, mod, modInv);
+                __m256i b1 = add(a1, a3, mod);
+                __m256i b3 = mul(sub(a1, a3, mod), w3, mod, modInv);
+                _mm256_storeu_si256((__m256i*)p, add(b0, b1, mod));
+                _mm256_storeu_si256((__m256i*)(p + h), mul(sub(b0, b1, mod), w1, mod, modInv));
+                _mm256_storeu_si256((__m256i*)(p + 2*h), add(b2, b3, mod));
+                _mm256_storeu_si256((__m256i*)(p + 3*h), mul(sub(b2, b3, mod), w1, mod, modInv));
+            } else {
+                a1 = mul(a1, w1, mod, modInv);
+                a3 = mul(a3, w1, mod, modInv);
+                __m256i b0 = add(a0, a1, mod), b1 = sub(a0, a1, mod);
+                __m256i b2 = mul(add(a2, a3, mod), w2, mod, modInv);
+                __m256i b3 = mul(sub(a2, a3, mod), w3, mod, modInv);
+                _mm256_storeu_si256((__m256i*)p, add(b0, b2, mod));
+                _mm256_storeu_si256((__m256i*)(p + 2*h), sub(b0, b2, mod));
+                _mm256_storeu_si256((__m256i*)(p + h), add(b1, b3, mod));
+                _mm256_storeu_si256((__m256i*)(p + 3*h), sub(b1, b3, mod));
+            }
+        }
+    }
+}
+
+#pragma GCC pop_options
+#endif
+
 }
 
+// Runs one radix-4 pass with SIMD if possible, returns false otherwise.
 template<typename C>
-class Convolution {
-    int sz, lgsz;
-    vector<C> roots, invRoots, lhs, rhs, res;
-    vector<int> rev;
+bool radix4Simd(C* c, const C* r, int sz, int h, int width, bool dif) {
+    return false;
+}
+
+#if defined(__x86_64__)
+bool radix4Simd(Complex* c, const Complex* r, int sz, int h, int width, bool dif) {
+    if (width % 2 != 0 || !simd::enabled())
+        return false;
+    simd::radix4(c, r, sz, h, width, dif);
+    return true;
+}
+
+template<uint32_t M, uint32_t G>
+bool radix4Simd(ModularField<M, G>* c, const ModularField<M, G>* r,
+    int sz, int h, int width, bool dif) {
+    if (width % 8 != 0 || !simd::enabled())
+        return false;
+    simd::radix4(reinterpret_cast<uint32_t*>(c), reinterpret_cast<const uint32_t*>(r),
+        sz, h, width, dif, M, ModularField<M, G>::modInv);
+    return true;
+}
+#endif
+
+// Worker threads shared by every parallel loop in the namespace. They are
+// started on first use, grow to the largest number ever asked for and
+// then stay, so a transform that splits every pass, or a batch called
+// thousands of times a second, never starts threads of its own.
+class ThreadPool {
+  public:
+    static ThreadPool& instance() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> guard(lock);
+            stop = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers)
+            t.join();
+    }
+
+    // Runs f(0), ..., f(n - 1) on the calling thread and up to helpers
+    // workers. The caller takes items too and only waits for workers that
+    // already joined in, so loops may nest and any thread may call it.
+    template<typename F>
+    void run(int n, int helpers, const F& f) {
+        Job job;
+        job.n = n;
+        job.f = &f;
+        job.call = [](const void* f, int i) { (*static_cast<const F*>(f))(i); };
+        {
+            lock_guard<mutex> guard(lock);
+            while ((int)workers.size() < helpers)
+                workers.emplace_back([this] { loop(); });
+            for (int t = 0; t < helpers; ++t)
+                queue.push_back(&job);
+        }
+        wake.notify_all();
+        job.work();
+        unique_lock<mutex> guard(lock);
+        queue.erase(remove(queue.begin(), queue.end(), &job), queue.end());
+        done.wait(guard, [&] { return job.active == 0; });
+    }
+
+  private:
+    struct Job {
+        atomic<int> next{0};
+        int n = 0;
+        // Workers running it, guarded by lock.
+        int active = 0;
+        const void* f = nullptr;
+        void (*call)(const void*, int) = nullptr;
+
+        void work() {
+            for (int i; (i = next++) < n; )
+                call(f, i);
+        }
+    };
+
+    mutex lock;
+    condition_variable wake, done;
+    deque<Job*> queue;
+    vector<thread> workers;
+    bool stop = false;
+
+    void loop() {
+        unique_lock<mutex> guard(lock);
+        while (true) {
+            wake.wait(guard, [&] { return stop || !queue.empty(); });
+            if (stop)
+                return;
+            Job* job = queue.front();
+            queue.pop_front();
+            ++job->active;
+            guard.unlock();
+            job->work();
+            guard.lock();
+            if (--job->active == 0)
+                done.notify_all();
+        }
+    }
+};
+
+// Runs f(0), ..., f(n - 1), spread over up to threads threads.
+template<typename F>
+void parallelFor(int n, int threads, const F& f) {
+    threads = min(threads, n);
+    if (threads <= 1) {
+        for (int i = 0; i < n; ++i)
+            f(i);
+        return;
+    }
+    ThreadPool::instance().run(n, threads - 1, f);
+}
+
+// Calls f(from, to) on consecutive ranges covering [0, n), one per thread.
+// Range bounds are multiples of 8 except for n itself.
+template<typename F>
+void parallelRanges(int n, int threads, const F& f) {
+    int chunk = ((n + threads - 1) / threads + 7) & ~7;
+    parallelFor(threads, threads, [&](int k) {
+        int from = min(n, k * chunk), to = min(n, from + chunk);
+        if (from < to)
+            f(from, to);
+    });
+}
+
+// Allocator for 64-byte aligned storage, so SIMD loads never straddle
+// cache lines.
+template<typename T>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    AlignedAllocator() {}
+
+    template<typename U>
+    AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), align_val_t(64)));
+    }
+
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, align_val_t(64));
+    }
+
+    template<typename U>
+    bool operator == (const AlignedAllocator<U>&) const {
+        return true;
+    }
+
+    template<typename U>
+    bool operator != (const AlignedAllocator<U>&) const {
+        return false;
+    }
+};
+
+// A transform plan, in the spirit of FFTW plans. It is built for a
+// maximum transform size and owns the root tables and aligned scratch
+// buffers, so transforms and convolutions up to that size never touch
+// the heap (convoluteInto only resizes out within its capacity).
+//
+// The forward transform is a decimation-in-frequency FFT that leaves the
+// spectrum in bit-reversed order, and the inverse is a decimation-in-time
+// FFT that takes it back, so no bit-reversal permutation is ever done.
+// Pointwise products don't care about the order.
+// Transforms larger than kBlockBytes recurse on contiguous sub-blocks
+// after their top passes, so every sub-block of kBlockBytes finishes all
+// of its remaining passes while it sits in L2. Those transforms are also
+// split over the plan's threads: the top passes by butterflies, the
+// sub-blocks as a whole.
+//
+// How to use:
+// fft::Plan<fft::Modular> plan(1<<20);
+// plan.convoluteInto(out, a, b);
+// Or, with an operand that doesn't change:
+// fft::Plan<fft::Modular>::Spectrum kernel;
+// plan.transform(kernel, b, plan.transformSize(a.size(), b.size()));
+// plan.convoluteInto(out, a, kernel);
+template<typename C>
+class Plan {
+  public:
+    typedef vector<C, AlignedAllocator<C>> Buffer;
+
+    // A transformed operand, reusable across convolutions.
+    struct Spectrum {
+        Buffer data;
+        int size = 0;
+    };
+
+  private:
+    static const int kBlockBytes = 1<<19;
+    static const int kBlock = kBlockBytes / sizeof(C);
+
+    int maxSize, threads;
+    Buffer roots, invRoots, x, y;
 
     static int nextPower2(int sz) {
         int i = 0;
@@ -171,73 +601,309 @@ class Convolution {
         return i;
     }
 
-    void precalc() {
-        if (2*sz != roots.size()) {
-            roots.resize(2*sz);
-            invRoots.resize(2*sz);
-            for (int j = (1<<lgsz); j < (1<<(lgsz+1)); ++j) {
-                roots[j] = C::root(lgsz, j - (1<<lgsz));
-                invRoots[j] = roots[j].inverse();
+    int threadsFor(int n) const {
+        return n > kBlock ? threads : 1;
+    }
+
+    // One radix-4 pass over c[0, n): the stages of half size 2h and h.
+    // Only the first width butterflies of each group of 4h are done.
+    static void radix4(C* c, const C* r, int n, int h, int width, bool dif) {
+        if (radix4Simd(c, r, n, h, width, dif))
+            return;
+        for (int start = 0; start < n; start += (h<<2)) {
+            C* p = c + start;
+            for (int i = 0; i < width; ++i) {
+                C w1 = r[i + (h<<1)];
+                C w2 = r[i + (h<<2)];
+                C w3 = r[i + h + (h<<2)];
+                if (dif) {
+                    C b0 = p[i] + p[i + 2*h], b2 = (p[i] - p[i + 2*h]) * w2;
+                    C b1 = p[i + h] + p[i + 3*h], b3 = (p[i + h] - p[i + 3*h]) * w3;
+                    p[i] = b0 + b1;
+                    p[i + h] = (b0 - b1) * w1;
+                    p[i + 2*h] = b2 + b3;
+                    p[i + 3*h] = (b2 - b3) * w1;
+                } else {
+                    C a1 = p[i + h] * w1, a3 = p[i + 3*h] * w1;
+                    C b0 = p[i] + a1, b1 = p[i] - a1;
+                    C b2 = (p[i + 2*h] + a3) * w2;
+                    C b3 = (p[i + 2*h] - a3) * w3;
+                    p[i] = b0 + b2;
+                    p[i + 2*h] = b0 - b2;
+                    p[i + h] = b1 + b3;
+                    p[i + 3*h] = b1 - b3;
+                }
             }
-            for (int j = (1<<lgsz) - 1; j >= 1; --j) {
-                roots[j] = roots[j<<1];
-                invRoots[j] = invRoots[j<<1];
-            }        
         }
+    }
 
-        if (sz != rev.size()) {
-            rev.resize(sz);
-            rev[0] = 0;
-            for (int i = 1; i < sz; ++i) {
-                rev[i] = (rev[i >> 1] >> 1) | ((i & 1) << (lgsz - 1));
+    // One radix-2 pass over c[0, n) with half size h.
+    static void radix2(C* c, const C* r, int n, int h, int width, bool dif) {
+        for (int start = 0; start < n; start += (h<<1)) {
+            C* p = c + start;
+            for (int i = 0; i < width; ++i) {
+                if (dif) {
+                    C d = p[i] - p[i + h];
+                    p[i] = p[i] + p[i + h];
+                    p[i + h] = d * r[i + (h<<1)];
+                } else {
+                    C w = p[i + h] * r[i + (h<<1)];
+                    p[i + h] = p[i] - w;
+                    p[i] = p[i] + w;
+                }
             }
         }
     }
 
-    void prepInverse() {
-        res.resize(sz);
-        for (int i = 0; i < sz; ++i) {
-            res[i] = lhs[i] * rhs[i];
+    // The top pass of a large transform, whose single group of
+    // butterflies is split between threads.
+    static void topPass(C* c, const C* r, int n, bool two, bool dif, int threads) {
+        int h = (two ? n >> 1 : n >> 2);
+        parallelRanges(h, threads, [&](int from, int to) {
+            if (two)
+                radix2(c + from, r + from, n, h, to - from, dif);
+            else radix4(c + from, r + from, n, h, to - from, dif);
+        });
+    }
+
+    // Natural order in, bit-reversed order out.
+    static void dif(C* c, const C* r, int n, int threads) {
+        if (n <= kBlock) {
+            int h = n >> 2;
+            for (; h >= 1; h >>= 2)
+                radix4(c, r, n, h, h, true);
+            if (nextPower2(n) & 1)
+                radix2(c, r, n, 1, 1, true);
+            return;
         }
+        int parts = (nextPower2(n / kBlock) & 1 ? 2 : 4);
+        topPass(c, r, n, parts == 2, true, threads);
+        parallelFor(parts, threads, [&](int k) {
+            dif(c + k * (n / parts), r, n / parts, max(1, threads / parts));
+        });
     }
 
-    void fft(vector<C>& c, bool invert) {
-        for (int i = 0; i < sz; ++i) {
-            if (i < rev[i])
-                swap(c[i], c[rev[i]]);
+    // Bit-reversed order in, natural order out.
+    static void dit(C* c, const C* r, int n, int threads) {
+        if (n <= kBlock) {
+            int h = 1;
+            if (nextPower2(n) & 1) {
+                radix2(c, r, n, 1, 1, false);
+                h = 2;
+            }
+            for (; h < n; h <<= 2)
+                radix4(c, r, n, h, h, false);
+            return;
         }
+        int parts = (nextPower2(n / kBlock) & 1 ? 2 : 4);
+        parallelFor(parts, threads, [&](int k) {
+            dit(c + k * (n / parts), r, n / parts, max(1, threads / parts));
+        });
+        topPass(c, r, n, parts == 2, false, threads);
+    }
 
-        auto& r = (invert ? invRoots : roots);
+    template<typename T>
+    static void toField(C* c, int n, const vector<T>& a) {
+        for (int i = 0; i < (int)a.size(); ++i)
+            c[i] = a[i];
+        for (int i = a.size(); i < n; ++i)
+            c[i] = 0;
+    }
 
-        for (int halfStep = 1; halfStep < sz; halfStep <<= 1) {
-            for (int start = 0; start < sz; start += (halfStep<<1)) {
-                for (int i = 0; i < halfStep; ++i) {
-                    C w = r[i + (halfStep<<1)] * c[start + i + halfStep];
-                    c[start + i + halfStep] = c[start + i] - w;
-                    c[start + i] = c[start + i] + w;
-                }
+    // Two real sequences share one complex transform: with z = a + ib,
+    // A[k] = (Z[k] + conj(Z[-k])) / 2 and B[k] = (Z[k] - conj(Z[-k])) / 2i,
+    // so A[k] * B[k] = (Z[k]^2 - conj(Z[-k]^2)) / 4i.
+    // In bit-reversed order, Z[-k] for an index j in [m, 2m) sits at
+    // j ^ (m - 1), and indices 0 and 1 are their own partners, so the
+    // product can be formed in place pair by pair.
+    template<typename T>
+    void packedProduct(const vector<T>& lhs, const vector<T>& rhs, int n,
+        C* z, int threads) const {
+        for (int i = 0; i < n; ++i)
+            z[i] = 0;
+        for (int i = 0; i < (int)lhs.size(); ++i)
+            z[i].a = lhs[i];
+        for (int i = 0; i < (int)rhs.size(); ++i)
+            z[i].b = rhs[i];
+        forward(z, n, threads);
+        const C quarter(0, -0.25);
+        parallelRanges(n, threads, [&](int from, int to) {
+            for (int i = from; i < to; ++i) {
+                int m = (i < 2 ? 1 : 1 << (31 - __builtin_clz(i)));
+                int j = i ^ (m - 1);
+                if (i > j)
+                    continue;
+                C zi = z[i], zj = z[j];
+                z[i] = (zi * zi - (zj * zj).conj()) * quarter;
+                z[j] = (zj * zj - (zi * zi).conj()) * quarter;
+            }
+        });
+        inverse(z, n, threads);
+    }
+
+  public:
+    Plan(int maxSize=1, int threads=1) : maxSize(0), threads(threads) {
+        reserve(maxSize);
+    }
+
+    // Grows the root tables and scratch buffers to transforms of size n.
+    // The tables only ever grow. Level m lives at [m, 2m) and does not
+    // depend on the transform size, so smaller transforms reuse them.
+    void reserve(int n) {
+        n = 1 << nextPower2(max(n, 2));
+        if (n <= maxSize)
+            return;
+        int from = max<int>(2*maxSize, 2);
+        roots.resize(2*n);
+        invRoots.resize(2*n);
+        roots[1] = invRoots[1] = 1;
+        fillRoots(roots.data(), from, n + 1);
+        for (int m = from; m <= n; m <<= 1) {
+            for (int t = 0; t < m; ++t) {
+                invRoots[m + t] = roots[m + ((m - t) & (m - 1))];
             }
         }
+        x.resize(n);
+        y.resize(n);
+        maxSize = n;
+    }
+
+    int capacity() const {
+        return maxSize;
+    }
+
+    // Size of the transforms that convolute operands of these sizes.
+    static int transformSize(int lhsSize, int rhsSize) {
+        return 1 << nextPower2(max(lhsSize + rhsSize - 1, 1));
+    }
 
-        if (invert) {
-            C mult = C(sz).inverse();
-            for (int i = 0; i < sz; ++i) {
+    // In place, natural order in, bit-reversed order out.
+    // n must be a power of two, at most capacity().
+    void forward(C* c, int n, int threads=0) const {
+        dif(c, roots.data(), n, threads ? threads : threadsFor(n));
+    }
+
+    // In place, bit-reversed order in, natural order out, scaled by 1/n.
+    void inverse(C* c, int n, int threads=0) const {
+        threads = (threads ? threads : threadsFor(n));
+        dit(c, invRoots.data(), n, threads);
+        C mult = C(n).inverse();
+        parallelRanges(n, threads, [&](int from, int to) {
+            for (int i = from; i < to; ++i)
                 c[i] = c[i] * mult;
-            }
+        });
+    }
+
+    // Transforms a, zero padded to n, into s.
+    template<typename T>
+    void transform(Spectrum& s, const vector<T>& a, int n) const {
+        s.data.resize(n);
+        s.size = a.size();
+        toField(s.data.data(), n, a);
+        forward(s.data.data(), n);
+    }
+
+    // Writes the product of lhs and rhs, still in the field, to x[0, n).
+    // y is scratch space. Only reads the plan, so several threads can
+    // run it at once with their own buffers.
+    template<typename T>
+    void product(const vector<T>& lhs, const vector<T>& rhs, int n,
+        C* x, C* y, int threads=0) const {
+        threads = (threads ? threads : threadsFor(n));
+        if constexpr (is_same<C, Complex>::value && is_arithmetic<T>::value) {
+            packedProduct(lhs, rhs, n, x, threads);
+            return;
         }
+        toField(x, n, lhs);
+        toField(y, n, rhs);
+        forward(x, n, threads);
+        forward(y, n, threads);
+        parallelRanges(n, threads, [&](int from, int to) {
+            for (int i = from; i < to; ++i)
+                x[i] = x[i] * y[i];
+        });
+        inverse(x, n, threads);
     }
 
+    // out = lhs * rhs, of size lhs.size() + rhs.size() - 1.
     template<typename T>
-    void toField(vector<C>& c, const vector<T>& a) {
-        c.resize(sz);
-        for (int i = 0; i < a.size(); ++i)
-            c[i] = a[i];
-        for (int i = a.size(); i < sz; ++i)
-            c[i] = 0;
+    void convoluteInto(vector<T>& out, const vector<T>& lhs, const vector<T>& rhs) {
+        if (lhs.empty() || rhs.empty()) {
+            out.clear();
+            return;
+        }
+        int n = transformSize(lhs.size(), rhs.size());
+        reserve(n);
+        product(lhs, rhs, n, x.data(), y.data());
+        out.resize(lhs.size() + rhs.size() - 1);
+        for (int i = 0; i < (int)out.size(); ++i)
+            assign(out[i], x[i]);
     }
 
+    // out = lhs * rhs, for a transformed rhs. Its transform size must be
+    // at least lhs.size() + rhs.size - 1.
     template<typename T>
-    void fromField(vector<T>& a, const vector<C>& c) {
+    void convoluteInto(vector<T>& out, const vector<T>& lhs, const Spectrum& rhs) {
+        if (lhs.empty() || rhs.size == 0) {
+            out.clear();
+            return;
+        }
+        int n = rhs.data.size();
+        toField(x.data(), n, lhs);
+        forward(x.data(), n);
+        int threads = threadsFor(n);
+        parallelRanges(n, threads, [&](int from, int to) {
+            for (int i = from; i < to; ++i)
+                x[i] = x[i] * rhs.data[i];
+        });
+        inverse(x.data(), n);
+        out.resize(lhs.size() + rhs.size - 1);
+        for (int i = 0; i < (int)out.size(); ++i)
+            assign(out[i], x[i]);
+    }
+};
+
+// res[0, n + m - 1) = a[0, n) * b[0, m), by definition.
+template<typename W>
+void schoolbook(const W* a, int n, const W* b, int m, W* res) {
+    for (int i = 0; i < n + m - 1; ++i)
+        res[i] = 0;
+    for (int i = 0; i < n; ++i) {
+        W x = a[i];
+        W* r = res + i;
+        for (int j = 0; j < m; ++j)
+            r[j] = r[j] + x * b[j];
+    }
+}
+
+// Convolution(threads) splits every large transform over that many
+// threads. convoluteBatch spreads independent pairs over threads.
+// The result of convolute is zero padded to the transform size.
+//
+// convolute picks its method by size (thresholds measured on AVX2 by the
+// timing in main; Karatsuba never beat both of its neighbours there):
+// - the shorter operand has at most kSchoolbook terms: schoolbook;
+// - the longer one is kOverlapRatio times the shorter one or more:
+//   overlap-add, with the shorter operand transformed only once;
+// - otherwise a single full-size transform.
+template<typename C>
+class Convolution {
+    static const int kSchoolbook = 24;
+    static const int kOverlapRatio = 4;
+
+    int sz;
+    Plan<C> plan;
+    typename Plan<C>::Buffer lhs, rhs;
+
+    static int nextPower2(int sz) {
+        int i = 0;
+        while ((1<<i) < sz)
+            ++i;
+        return i;
+    }
+
+    template<typename T, typename V>
+    void fromField(vector<T>& a, const V& c) const {
         a.resize(sz);
         for (int i = 0; i < sz; ++i) {
             assign(a[i], c[i]);
@@ -245,25 +911,513 @@ class Convolution {
     }
 
   public:
+    Convolution(int threads=1) : plan(1, threads) {}
+
+    // Same as convolute, but leaves the result in the field.
+    // The returned buffer is overwritten by the next call.
+    template<typename T>
+    const typename Plan<C>::Buffer& convoluteInField(const vector<T>& lhs, const vector<T>& rhs) {
+        sz = (2 << nextPower2(max(lhs.size(), rhs.size())));
+        plan.reserve(sz);
+        this->lhs.resize(sz);
+        this->rhs.resize(sz);
+        plan.product(lhs, rhs, sz, this->lhs.data(), this->rhs.data());
+        return this->lhs;
+    }
+
+    // Schoolbook. The work type W is double for real DFT inputs and the
+    // field itself otherwise, so the results match the transforms.
+    template<typename T>
+    void direct(const vector<T>& lng, const vector<T>& shrt, vector<T>& res) {
+        typedef typename conditional<is_same<C, Complex>::value && is_arithmetic<T>::value,
+            double, C>::type W;
+        int n = lng.size(), m = shrt.size();
+        vector<W> a(lng.begin(), lng.end()), b(shrt.begin(), shrt.end());
+        vector<W> out(n + m - 1);
+        schoolbook(a.data(), n, b.data(), m, out.data());
+        res.assign(sz, T());
+        for (int i = 0; i < n + m - 1; ++i)
+            assign(res[i], C(out[i]));
+    }
+
+    // Overlap-add: long is cut into blocks that fill a transform of
+    // about twice the length of short, whose transform is reused.
+    template<typename T>
+    void overlapAdd(const vector<T>& lng, const vector<T>& shrt, vector<T>& res) {
+        int n = lng.size(), m = shrt.size();
+        int size = 2 << nextPower2(m);
+        int block = size - m + 1;
+        plan.reserve(size);
+        typename Plan<C>::Spectrum spectrum;
+        plan.transform(spectrum, shrt, size);
+        vector<T> piece, out;
+        res.assign(sz, T());
+        for (int start = 0; start < n; start += block) {
+            piece.assign(lng.begin() + start, lng.begin() + min(n, start + block));
+            plan.convoluteInto(out, piece, spectrum);
+            for (int i = 0; i < (int)out.size(); ++i)
+                res[start + i] += out[i];
+        }
+    }
+
     template<typename T>
     vector<T> convolute(const vector<T>& lhs, const vector<T>& rhs) {
-        lgsz = 1 + nextPower2(max(lhs.size(), rhs.size()));
-        sz = (1<<lgsz);
-        precalc();
-        toField(this->lhs, lhs);
-        toField(this->rhs, rhs);
-        fft(this->lhs, false);
-        fft(this->rhs, false);
-        prepInverse();
-        fft(this->res, true);
         vector<T> res;
-        fromField(res, this->res);
+        if (lhs.empty() || rhs.empty())
+            return res;
+        const vector<T>& lng = (lhs.size() >= rhs.size() ? lhs : rhs);
+        const vector<T>& shrt = (lhs.size() >= rhs.size() ? rhs : lhs);
+        sz = (2 << nextPower2(lng.size()));
+        if (shrt.size() <= kSchoolbook) {
+            direct(lng, shrt, res);
+        } else if (lng.size() >= kOverlapRatio * shrt.size()) {
+            overlapAdd(lng, shrt, res);
+        } else {
+            convoluteInField(lhs, rhs);
+            fromField(res, this->lhs);
+        }
+        return res;
+    }
+
+    // Convolutes lhs[k] with rhs[k] for every k on up to threads threads.
+    // All pairs use the transform size of the largest one and share the
+    // plan; each thread only owns its scratch buffers.
+    template<typename T>
+    vector<vector<T>> convoluteBatch(const vector<vector<T>>& lhs,
+        const vector<vector<T>>& rhs, int threads) {
+        size_t maxSize = 1;
+        for (int k = 0; k < (int)lhs.size(); ++k)
+            maxSize = max(maxSize, max(lhs[k].size(), rhs[k].size()));
+        sz = (2 << nextPower2(maxSize));
+        plan.reserve(sz);
+
+        vector<vector<T>> res(lhs.size());
+        atomic<int> next(0);
+        parallelFor(threads, threads, [&](int) {
+            typename Plan<C>::Buffer x(sz), y(sz);
+            for (int k; (k = next++) < (int)lhs.size(); ) {
+                plan.product(lhs[k], rhs[k], sz, x.data(), y.data(), 1);
+                fromField(res[k], x);
+            }
+        });
         return res;
     }
 };
 
 typedef Convolution<Complex> DFT;
 typedef Convolution<Modular> NTT;
+
+// Exact integer convolution through NTTs over three primes, recombined
+// with Garner's algorithm (CRT for pairwise coprime moduli).
+// The product of the primes is about 1.6 * 10^26, so every output must
+// lie in (-8 * 10^25, 8 * 10^25); e.g. inputs below 10^9+7 and sizes up
+// to 2^25 for convoluteMod. The array sizes should be at most 2^24.
+class MultiModConvolution {
+    typedef ModularField<2013265921, 31> F1;
+    typedef ModularField<469762049, 3> F2;
+    typedef ModularField<167772161, 3> F3;
+
+    Convolution<F1> c1;
+    Convolution<F2> c2;
+    Convolution<F3> c3;
+
+    static constexpr int64 p1 = F1::mod, p2 = F2::mod, p3 = F3::mod;
+
+    // Garner digits: the value is r1 + p1 * k1 + p1 * p2 * k2.
+    struct Digits {
+        int64 r1, k1, k2;
+    };
+
+    vector<Digits> digits;
+
+    template<typename T>
+    void solve(const vector<T>& lhs, const vector<T>& rhs) {
+        static const int64 inv1 = F2(p1).inverse().value();
+        static const int64 inv12 = F3(p1 * p2 % p3).inverse().value();
+        const auto& a = c1.convoluteInField(lhs, rhs);
+        const auto& b = c2.convoluteInField(lhs, rhs);
+        const auto& c = c3.convoluteInField(lhs, rhs);
+        digits.resize(a.size());
+        for (int i = 0; i < (int)a.size(); ++i) {
+            int64 r1 = a[i].value(), r2 = b[i].value(), r3 = c[i].value();
+            int64 k1 = (r2 - r1 % p2 + p2) % p2 * inv1 % p2;
+            int64 k2 = ((r3 - (r1 + p1 * k1) % p3) % p3 + p3) % p3 * inv12 % p3;
+            digits[i] = {r1, k1, k2};
+        }
+    }
+
+  public:
+    // Exact result, for outputs that fit in int64.
+    vector<int64> convolute(const vector<int64>& lhs, const vector<int64>& rhs) {
+        solve(lhs, rhs);
+        const __int128 total = (__int128)p1 * p2 * p3;
+        vector<int64> res(digits.size());
+        for (int i = 0; i < (int)digits.size(); ++i) {
+            __int128 x = digits[i].r1 + (__int128)p1 * digits[i].k1
+                + (__int128)p1 * p2 * digits[i].k2;
+            if (x > total / 2)
+                x -= total;
+            res[i] = x;
+        }
+        return res;
+    }
+
+    // Result modulo mod, for inputs in [0, mod) and mod < 2^31.
+    vector<int64> convoluteMod(const vector<int64>& lhs, const vector<int64>& rhs, int64 mod) {
+        solve(lhs, rhs);
+        int64 p12 = p1 * p2 % mod;
+        vector<int64> res(digits.size());
+        for (int i = 0; i < (int)digits.size(); ++i) {
+            res[i] = (digits[i].r1 + p1 % mod * digits[i].k1 + p12 * digits[i].k2) % mod;
+        }
+        return res;
+    }
+};
+
+// Exact int64 convolution through complex FFTs. Every coefficient is cut
+// into balanced 16-bit limbs, a = a0 + a1 2^16 + a2 2^32 + ..., and the
+// limb products are formed in the frequency domain. Two real sequences
+// share each transform, so K limbs per operand cost 2 * ceil(K/2)
+// forward and K inverse transforms: 4 FFTs for inputs below 2^31.
+// Every limb product must round to an integer; if any output lands more
+// than kMaxError away from one, the result is recomputed with
+// MultiModConvolution instead. Either way the result is exact as long
+// as it fits in int64.
+class ExactConvolution {
+    static const int kLimbBits = 16;
+    static constexpr double kMaxError = 0.1;
+
+    typedef Plan<Complex>::Buffer Buffer;
+
+    Plan<Complex> plan;
+    MultiModConvolution fallback;
+
+    // Cuts the lowest balanced limb, in [-2^15, 2^15), off x. x - limb
+    // may be 2^63, so x is shifted first and a negative limb carries one
+    // into the rest; nothing overflows for any int64.
+    static int64 nextLimb(int64& x) {
+        const uint64_t half = 1 << (kLimbBits-1);
+        int64 limb = (int64)(((uint64_t)x + half) & ((1<<kLimbBits) - 1)) - (int64)half;
+        x = (x >> kLimbBits) + (limb < 0);
+        return limb;
+    }
+
+    static int limbCount(const vector<int64>& a) {
+        int count = 1;
+        for (int64 x : a) {
+            int k = 0;
+            while (x != 0) {
+                nextLimb(x);
+                ++k;
+            }
+            count = max(count, k);
+        }
+        return count;
+    }
+
+    // Packs limbs 2t and 2t+1 of a into the real and imaginary parts of
+    // packed[t], then transforms them.
+    void splitAndTransform(const vector<int64>& a, int limbs, int n, vector<Buffer>& packed) {
+        packed.assign((limbs + 1) / 2, Buffer(n));
+        for (int i = 0; i < (int)a.size(); ++i) {
+            int64 x = a[i];
+            for (int k = 0; k < limbs; ++k) {
+                int64 limb = nextLimb(x);
+                (k & 1 ? packed[k>>1][i].b : packed[k>>1][i].a) = limb;
+            }
+        }
+        for (auto& p : packed)
+            plan.forward(p.data(), n);
+    }
+
+    // Spectra of the limbs at index i, whose conjugate partner is at j.
+    static void unpack(const vector<Buffer>& packed, int limbs, int i, int j, Complex* spectra) {
+        const Complex half(0.5, 0), halfInv(0, -0.5);
+        for (int k = 0; k < limbs; ++k) {
+            const Complex& z = packed[k>>1][i];
+            Complex zj = packed[k>>1][j].conj();
+            spectra[k] = (k & 1 ? (z - zj) * halfInv : (z + zj) * half);
+        }
+    }
+
+  public:
+    // The exact convolution, of size lhs.size() + rhs.size() - 1.
+    vector<int64> convolute(const vector<int64>& lhs, const vector<int64>& rhs) {
+        int ka = limbCount(lhs), kb = limbCount(rhs);
+        int outLimbs = ka + kb - 1;
+        int n = plan.transformSize(lhs.size(), rhs.size());
+        plan.reserve(n);
+
+        vector<Buffer> pa, pb, out((outLimbs + 1) / 2, Buffer(n));
+        splitAndTransform(lhs, ka, n, pa);
+        splitAndTransform(rhs, kb, n, pb);
+
+        // out[u] = C_2u + i C_2u+1, where C_s = sum over i + j = s of A_i B_j.
+        Complex sa[8], sb[8], prod[16];
+        for (int i = 0; i < n; ++i) {
+            int m = (i < 2 ? 1 : 1 << (31 - __builtin_clz(i)));
+            int j = i ^ (m - 1);
+            unpack(pa, ka, i, j, sa);
+            unpack(pb, kb, i, j, sb);
+            for (int s = 0; s < outLimbs; ++s)
+                prod[s] = 0;
+            for (int x = 0; x < ka; ++x)
+                for (int y = 0; y < kb; ++y)
+                    prod[x + y] = prod[x + y] + sa[x] * sb[y];
+            for (int s = 0; s < outLimbs; s += 2)
+                out[s>>1][i] = prod[s] + (s + 1 < outLimbs ? prod[s + 1] * Complex(0, 1) : Complex());
+        }
+
+        int size = lhs.size() + rhs.size() - 1;
+        vector<uint64_t> res(size);
+        double error = 0;
+        for (int u = 0; u < (int)out.size(); ++u) {
+            plan.inverse(out[u].data(), n);
+            for (int i = 0; i < size; ++i) {
+                double parts[2] = {out[u][i].a, out[u][i].b};
+                for (int k = 0; k < 2 && 2*u + k < outLimbs; ++k) {
+                    int64 r = llround(parts[k]);
+                    error = max(error, fabs(parts[k] - r));
+                    // Limbs past bit 64 only matter for results that overflow.
+                    if (kLimbBits * (2*u + k) < 64)
+                        res[i] += (uint64_t)r << (kLimbBits * (2*u + k));
+                }
+            }
+        }
+
+        if (error > kMaxError) {
+            auto exact = fallback.convolute(lhs, rhs);
+            exact.resize(size);
+            return exact;
+        }
+        return vector<int64>(res.begin(), res.end());
+    }
+};
+
+// Polynomial and power series operations over an NTT field F, such as
+// Modular or ModularField<998244353, 3>. Coefficients are stored lowest
+// degree first. Everything runs in O(n log n), except evaluation and
+// interpolation which run in O(n log^2 n) over a subproduct tree.
+// The Newton iterations transform each iterate once and reuse it for
+// both products of the step.
+template<typename F>
+class Polynomials {
+    typedef vector<F> Poly;
+
+    static const int kNaive = 32;
+
+    Plan<F> plan;
+    Poly inverses;
+
+    // Makes inverses[i] = 1/i valid for i < n.
+    void precalcInverses(int n) {
+        if ((int)inverses.size() >= n)
+            return;
+        int from = max<int>(inverses.size(), 2);
+        inverses.resize(n);
+        inverses[1] = 1;
+        for (int i = from; i < n; ++i) {
+            inverses[i] = F(-(int64)(F::mod / i)) * inverses[F::mod % i];
+        }
+    }
+
+    static Poly truncated(const Poly& a, int n) {
+        Poly res(a.begin(), a.begin() + min<int>(n, a.size()));
+        res.resize(n);
+        return res;
+    }
+
+    // Products of (x - points[i]) over the subtree ranges.
+    void buildTree(vector<Poly>& tree, int node, int left, int right, const vector<F>& points) {
+        if (left == right) {
+            tree[node] = {F(0) - points[left], F(1)};
+            return;
+        }
+        int mid = (left + right) >> 1;
+        buildTree(tree, node<<1, left, mid, points);
+        buildTree(tree, node<<1^1, mid+1, right, points);
+        tree[node] = multiply(tree[node<<1], tree[node<<1^1]);
+    }
+
+    // Evaluates a at points[left..right], reducing it modulo the subtree
+    // products on the way down.
+    void evaluateTree(const vector<Poly>& tree, int node, int left, int right,
+        const Poly& a, const vector<F>& points, vector<F>& values) {
+        Poly rem = divide(a, tree[node]).second;
+        if (right - left < kNaive) {
+            for (int i = left; i <= right; ++i) {
+                F v = 0;
+                for (int j = (int)rem.size() - 1; j >= 0; --j)
+                    v = v * points[i] + rem[j];
+                values[i] = v;
+            }
+            return;
+        }
+        int mid = (left + right) >> 1;
+        evaluateTree(tree, node<<1, left, mid, rem, points, values);
+        evaluateTree(tree, node<<1^1, mid+1, right, rem, points, values);
+    }
+
+    // Sum of weights[i] * prod_{j != i} (x - points[j]) over the subtree.
+    Poly combineTree(const vector<Poly>& tree, int node, int left, int right,
+        const vector<F>& weights) {
+        if (left == right)
+            return {weights[left]};
+        int mid = (left + right) >> 1;
+        Poly res = multiply(combineTree(tree, node<<1, left, mid, weights), tree[node<<1^1]);
+        Poly other = multiply(combineTree(tree, node<<1^1, mid+1, right, weights), tree[node<<1]);
+        res.resize(max(res.size(), other.size()));
+        for (int i = 0; i < (int)other.size(); ++i)
+            res[i] = res[i] + other[i];
+        return res;
+    }
+
+  public:
+    Poly multiply(const Poly& a, const Poly& b) {
+        if (a.empty() || b.empty())
+            return {};
+        Poly res;
+        if (min(a.size(), b.size()) <= kNaive) {
+            res.assign(a.size() + b.size() - 1, 0);
+            for (int i = 0; i < (int)a.size(); ++i)
+                for (int j = 0; j < (int)b.size(); ++j)
+                    res[i + j] = res[i + j] + a[i] * b[j];
+            return res;
+        }
+        plan.convoluteInto(res, a, b);
+        return res;
+    }
+
+    // First n terms of 1/a. Needs a[0] != 0.
+    // Newton step: g <- g * (2 - a * g) mod x^2k.
+    Poly inverse(const Poly& a, int n) {
+        Poly g{a[0].inverse()};
+        typename Plan<F>::Buffer fa, fg;
+        for (int k = 1; k < n; k <<= 1) {
+            int sz = 4*k;
+            plan.reserve(sz);
+            fa.assign(sz, 0);
+            fg.assign(sz, 0);
+            copy(a.begin(), a.begin() + min<int>(2*k, a.size()), fa.begin());
+            copy(g.begin(), g.end(), fg.begin());
+            plan.forward(fa.data(), sz);
+            plan.forward(fg.data(), sz);
+            for (int i = 0; i < sz; ++i)
+                fg[i] = fg[i] * (F(2) - fg[i] * fa[i]);
+            plan.inverse(fg.data(), sz);
+            g.assign(fg.begin(), fg.begin() + 2*k);
+        }
+        g.resize(n);
+        return g;
+    }
+
+    // Returns (q, r) with a = q * b + r and deg r < deg b.
+    // Needs the leading coefficient of b to be nonzero.
+    pair<Poly, Poly> divide(const Poly& a, const Poly& b) {
+        int n = a.size(), m = b.size();
+        if (n < m)
+            return {{}, a};
+        int k = n - m + 1;
+        Poly ra(a.rbegin(), a.rbegin() + k), rb(b.rbegin(), b.rend());
+        Poly q = truncated(multiply(ra, inverse(rb, k)), k);
+        reverse(q.begin(), q.end());
+        Poly qb = multiply(q, b);
+        Poly r(m - 1);
+        for (int i = 0; i < m - 1; ++i)
+            r[i] = a[i] - qb[i];
+        while (!r.empty() && r.back().value() == 0)
+            r.pop_back();
+        return {q, r};
+    }
+
+    Poly derivative(const Poly& a) {
+        Poly res(max<int>(a.size(), 1) - 1);
+        for (int i = 1; i < (int)a.size(); ++i)
+            res[i - 1] = a[i] * F(i);
+        return res;
+    }
+
+    Poly integral(const Poly& a) {
+        precalcInverses(a.size() + 1);
+        Poly res(a.size() + 1);
+        for (int i = 0; i < (int)a.size(); ++i)
+            res[i + 1] = a[i] * inverses[i + 1];
+        return res;
+    }
+
+    // First n terms of log(a). Needs a[0] = 1.
+    Poly log(const Poly& a, int n) {
+        Poly d = truncated(multiply(derivative(truncated(a, n)), inverse(a, n)), n - 1);
+        return truncated(integral(d), n);
+    }
+
+    // First n terms of exp(a). Needs a[0] = 0.
+    // Newton step: f <- f * (1 - log(f) + a) mod x^2k.
+    Poly exp(const Poly& a, int n) {
+        Poly f{F(1)};
+        for (int k = 1; k < n; k <<= 1) {
+            Poly t = log(f, 2*k);
+            for (int i = 0; i < 2*k; ++i)
+                t[i] = (i < (int)a.size() ? a[i] : F(0)) - t[i];
+            t[0] = t[0] + F(1);
+            f = truncated(multiply(f, t), 2*k);
+        }
+        return truncated(f, n);
+    }
+
+    // First n terms of a^k.
+    Poly pow(const Poly& a, int64 k, int n) {
+        if (k == 0)
+            return truncated({F(1)}, n);
+        int t = 0;
+        while (t < (int)a.size() && a[t].value() == 0)
+            ++t;
+        if (t == (int)a.size() || t > (n - 1) / k)
+            return Poly(n);
+        int shift = t * k;
+        F c = a[t], cInv = c.inverse();
+        Poly b(a.begin() + t, a.end());
+        for (auto& x : b)
+            x = x * cInv;
+        Poly l = log(b, n - shift);
+        F kf(k % F::mod);
+        for (auto& x : l)
+            x = x * kf;
+        Poly e = exp(l, n - shift);
+        F ck(F::lgpow(c.value(), k % (F::mod - 1)));
+        Poly res(n);
+        for (int i = 0; i < n - shift; ++i)
+            res[i + shift] = e[i] * ck;
+        return res;
+    }
+
+    // Values of a at every point.
+    vector<F> evaluate(const Poly& a, const vector<F>& points) {
+        int n = points.size();
+        vector<F> values(n);
+        if (n == 0)
+            return values;
+        vector<Poly> tree(4*n);
+        buildTree(tree, 1, 0, n - 1, points);
+        evaluateTree(tree, 1, 0, n - 1, a, points, values);
+        return values;
+    }
+
+    // The polynomial of degree < n through (xs[i], ys[i]).
+    // Needs the xs to be distinct.
+    Poly interpolate(const vector<F>& xs, const vector<F>& ys) {
+        int n = xs.size();
+        if (n == 0)
+            return {};
+        vector<Poly> tree(4*n);
+        buildTree(tree, 1, 0, n - 1, xs);
+        vector<F> weights(n);
+        evaluateTree(tree, 1, 0, n - 1, derivative(tree[1]), xs, weights);
+        for (int i = 0; i < n; ++i)
+            weights[i] = ys[i] * weights[i].inverse();
+        return combineTree(tree, 1, 0, n - 1, weights);
+    }
+};
 };
 
 int main() {
@@ -271,7 +1425,41 @@ int main() {
     
     fft::DFT dft;
 	auto c = dft.convolute(a, b);
-	for (int i = 0; i < c.size(); ++i) {
+	for (int i = 0; i < (int)c.size(); ++i) {
 		cout << c[i] << "\n";
 	}
+
+	// An empty operand gives an empty product.
+	cout << dft.convolute(a, vector<int>()).size() << "\n";
+
+	// Exact at the ends of the int64 range.
+	fft::ExactConvolution exact;
+	auto d = exact.convolute({INT64_MAX, INT64_MIN}, {1, 0});
+	cout << d[0] << " " << d[1] << "\n";
+
+	// Schoolbook against one transform for a long operand and a short one
+	// of m terms; where they cross sets Convolution::kSchoolbook.
+	auto micros = [](const auto& f) {
+		auto start = chrono::steady_clock::now();
+		for (int r = 0; r < 100; ++r)
+			f();
+		return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / 100;
+	};
+	vector<int> lng(4096, 12345), out;
+	for (int m : {16, 24, 32, 48, 64}) {
+		vector<int> shrt(m, 678);
+		double transform = micros([&] { dft.convoluteInField(lng, shrt); });
+		double direct = micros([&] { dft.direct(lng, shrt, out); });
+		cout << "m = " << m << ": schoolbook " << direct << " us, transform " << transform << " us\n";
+	}
+
+	// Batch throughput by number of threads.
+	vector<vector<int>> xs(256, vector<int>(4096, 1)), ys = xs;
+	int cores = max(1u, thread::hardware_concurrency());
+	for (int threads = 1; threads <= cores; threads *= 2) {
+		auto start = chrono::steady_clock::now();
+		dft.convoluteBatch(xs, ys, threads);
+		double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		cout << threads << " threads: " << xs.size() / seconds << " convolutions/s\n";
+	}
 }
\ No newline at end of file
@@ -4,19 +4,55 @@
 #include <tuple>
 #include <cassert>
 #include <vector>
+#include <limits>
+#include <type_traits>
+#include <thread>
+#include <queue>
+#include <map>
+#include <set>
+#include <numeric>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
-typedef double T;
+// Point<T> works with double as well as with integer coordinates
+// (int, int64_t, __int128). Integer points get exact dot, cross and det
+// without any epsilon, computed in Wide<T>. That never overflows for int;
+// for int64_t, det needs coordinates below 2^62 in absolute value. Wide of
+// __int128 is __int128 itself, so __int128 coordinates are only exact
+// below 2^62 as well.
+// Functions that divide or take square roots need floating-point T.
 
-const T EPS = 1e-12;
+const double EPS = 1e-12;
 
+// Type holding the product of two coordinates exactly.
+template<typename T> struct WideType { typedef T type; };
+template<> struct WideType<int> { typedef long long type; };
+template<> struct WideType<long> { typedef __int128 type; };
+template<> struct WideType<long long> { typedef __int128 type; };
+
+template<typename T>
+using Wide = typename WideType<T>::type;
+
+// Type of lengths and distances.
+template<typename T>
+using Real = typename conditional<is_floating_point<T>::value, T, double>::type;
+
+// Compares with EPS for floating point types, exactly otherwise.
+template<typename T>
 bool equal(const T& a, const T& b) {
-    return (fabs(a - b) < EPS);
+    if constexpr (is_floating_point<T>::value) {
+        return (fabs(a - b) < EPS);
+    } else {
+        return a == b;
+    }
 }
 
-const T pi = acos(-1);
+const double pi = acos(-1);
 
+template<typename T>
 struct Point {
     T x, y;
 
@@ -72,12 +108,12 @@ struct Point {
         return y < other.y;
     }
 
-    T len() const {
-        return sqrt(x*x + y*y);
+    Real<T> len() const {
+        return sqrt((Real<T>)sqrlen());
     }
 
-    T sqrlen() const {
-        return x*x + y*y;
+    Wide<T> sqrlen() const {
+        return (Wide<T>)x*x + (Wide<T>)y*y;
     }
 
     void normalize() {
@@ -87,76 +123,473 @@ struct Point {
     }
 };
 
-istream& operator >> (istream& in, Point& p) {
+template<typename T>
+istream& operator >> (istream& in, Point<T>& p) {
     in >> p.x >> p.y;
     return in;
 }
 
-ostream& operator << (ostream& out, const Point& p) {
+template<typename T>
+ostream& operator << (ostream& out, const Point<T>& p) {
     out << "(" << p.x << ", " << p.y << ")";
     return out;
 }
 
-T dot(const Point& a, const Point& b) {
-    return a.x * b.x + a.y * b.y;
+template<typename T>
+Wide<T> dot(const Point<T>& a, const Point<T>& b) {
+    return (Wide<T>)a.x * b.x + (Wide<T>)a.y * b.y;
+}
+
+template<typename T>
+Wide<T> cross(const Point<T>& a, const Point<T>& b) {
+    return (Wide<T>)a.x * b.y - (Wide<T>)a.y * b.x;
 }
 
-T cross(const Point& a, const Point& b) {
-    return a.x * b.y - a.y * b.x;
+// Exact for int64_t coordinates below 2^62 in absolute value.
+template<typename T>
+Wide<T> det(const Point<T>& a, const Point<T>& b, const Point<T>& c) {
+    typedef Wide<T> W;
+    return (W(b.x) - a.x) * (W(c.y) - a.y) - (W(c.x) - a.x) * (W(b.y) - a.y);
 }
 
-T det(const Point& a, const Point& b, const Point& c) {
-    return (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+template<typename T>
+Wide<T> sqrdist(const Point<T>& a, const Point<T>& b) {
+    typedef Wide<T> W;
+    return (W(b.x) - a.x) * (W(b.x) - a.x) + (W(b.y) - a.y) * (W(b.y) - a.y);
+}
+
+template<typename T>
+Real<T> dist(const Point<T>& a, const Point<T>& b) {
+    return sqrt((Real<T>)sqrdist(a, b));
+}
+
+// Structure-of-arrays storage for large point sets. The batch kernels below
+// stream over the coordinate arrays, which keeps them cache and SIMD friendly.
+template<typename T>
+struct PointBatch {
+    vector<T> x, y;
+
+    PointBatch() {}
+
+    PointBatch(const vector<Point<T>>& v) {
+        x.reserve(v.size());
+        y.reserve(v.size());
+        for (const Point<T>& p : v) {
+            push_back(p);
+        }
+    }
+
+    int size() const {
+        return x.size();
+    }
+
+    void push_back(const Point<T>& p) {
+        x.push_back(p.x);
+        y.push_back(p.y);
+    }
+
+    Point<T> operator [] (int i) const {
+        return {x[i], y[i]};
+    }
+};
+
+// AVX2 versions of the double batch kernels, used when the CPU supports them.
+// They round exactly like det and sqrdist, so results match the scalar code.
+namespace simd {
+
+#if defined(__x86_64__)
+bool enabled() {
+    static const bool ok = __builtin_cpu_supports("avx2");
+    return ok;
+}
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+void det(double ax, double ay, double bx, double by,
+    const double* x, const double* y, int n, double* out) {
+    __m256d vax = _mm256_set1_pd(ax), vay = _mm256_set1_pd(ay);
+    __m256d ux = _mm256_set1_pd(bx - ax), uy = _mm256_set1_pd(by - ay);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d vx = _mm256_sub_pd(_mm256_loadu_pd(x + i), vax);
+        __m256d vy = _mm256_sub_pd(_mm256_loadu_pd(y + i), vay);
+        _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_mul_pd(ux, vy), _mm256_mul_pd(vx, uy)));
+    }
+    for (; i < n; ++i) {
+        out[i] = (bx - ax) * (y[i] - ay) - (x[i] - ax) * (by - ay);
+    }
+}
+
+void sqrdist(double px, double py, const double* x, const double* y, int n, double* out) {
+    __m256d vpx = _mm256_set1_pd(px), vpy = _mm256_set1_pd(py);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + i), vpx);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + i), vpy);
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+    }
+    for (; i < n; ++i) {
+        out[i] = (x[i] - px) * (x[i] - px) + (y[i] - py) * (y[i] - py);
+    }
+}
+
+#pragma GCC pop_options
+#else
+bool enabled() {
+    return false;
+}
+
+void det(double, double, double, double, const double*, const double*, int, double*) {}
+
+void sqrdist(double, double, const double*, const double*, int, double*) {}
+#endif
+
+}
+
+// out[i - from] = det(a, b, batch[i]) for i in [from, to).
+template<typename T>
+void BatchDet(const Point<T>& a, const Point<T>& b, const PointBatch<T>& batch,
+    int from, int to, Wide<T>* out) {
+    if constexpr (is_same<T, double>::value) {
+        if (simd::enabled()) {
+            simd::det(a.x, a.y, b.x, b.y, batch.x.data() + from, batch.y.data() + from, to - from, out);
+            return;
+        }
+    }
+    for (int i = from; i < to; ++i) {
+        out[i - from] = det(a, b, Point<T>(batch.x[i], batch.y[i]));
+    }
+}
+
+// out[i - from] = sqrdist(p, batch[i]) for i in [from, to).
+template<typename T>
+void BatchSqrdist(const Point<T>& p, const PointBatch<T>& batch, int from, int to, Wide<T>* out) {
+    if constexpr (is_same<T, double>::value) {
+        if (simd::enabled()) {
+            simd::sqrdist(p.x, p.y, batch.x.data() + from, batch.y.data() + from, to - from, out);
+            return;
+        }
+    }
+    for (int i = from; i < to; ++i) {
+        out[i - from] = sqrdist(p, Point<T>(batch.x[i], batch.y[i]));
+    }
+}
+
+// Index of the point of batch closest to p (farthest if farthest=true),
+// -1 if batch is empty. Works on blocks that stay in L1 cache.
+template<typename T>
+int ClosestPoint(const Point<T>& p, const PointBatch<T>& batch, bool farthest=false) {
+    const int kBlock = 1024;
+    Wide<T> d[kBlock];
+    int best = -1;
+    Wide<T> bestDist = 0;
+    for (int from = 0; from < batch.size(); from += kBlock) {
+        int to = min(from + kBlock, batch.size());
+        BatchSqrdist(p, batch, from, to, d);
+        for (int i = from; i < to; ++i) {
+            if (best == -1 || (farthest ? d[i - from] > bestDist : d[i - from] < bestDist)) {
+                best = i;
+                bestDist = d[i - from];
+            }
+        }
+    }
+    return best;
+}
+
+// Exact arithmetic on expansions: sums of non-overlapping doubles stored in
+// increasing order of magnitude. Only reached when the floating-point filters
+// of the predicates below cannot decide the sign, so it favours simplicity.
+// Assumes no intermediate overflows.
+namespace exact {
+    typedef vector<double> Expansion;
+
+    const double kEpsilon = numeric_limits<double>::epsilon() / 2;
+
+    void twoSum(double a, double b, double& x, double& y) {
+        x = a + b;
+        double bv = x - a;
+        double av = x - bv;
+        y = (a - av) + (b - bv);
+    }
+
+    void twoProduct(double a, double b, double& x, double& y) {
+        x = a * b;
+        y = fma(a, b, -x);
+    }
+
+    Expansion grow(const Expansion& e, double b) {
+        Expansion h;
+        h.reserve(e.size() + 1);
+        for (double c : e) {
+            double lo;
+            twoSum(b, c, b, lo);
+            if (lo != 0) {
+                h.push_back(lo);
+            }
+        }
+        if (b != 0 || h.empty()) {
+            h.push_back(b);
+        }
+        return h;
+    }
+
+    Expansion sum(Expansion e, const Expansion& f) {
+        for (double c : f) {
+            e = grow(e, c);
+        }
+        return e;
+    }
+
+    Expansion product(const Expansion& e, const Expansion& f) {
+        Expansion h;
+        for (double a : e) {
+            for (double b : f) {
+                double hi, lo;
+                twoProduct(a, b, hi, lo);
+                h = grow(grow(h, lo), hi);
+            }
+        }
+        return h;
+    }
+
+    Expansion negate(Expansion e) {
+        for (double& c : e) {
+            c = -c;
+        }
+        return e;
+    }
+
+    // The last component dominates the rest.
+    int sign(const Expansion& e) {
+        for (int i = (int)e.size() - 1; i >= 0; --i) {
+            if (e[i] != 0) {
+                return e[i] > 0 ? 1 : -1;
+            }
+        }
+        return 0;
+    }
+
+    // Exact equality, unlike Point::operator ==.
+    bool same(const Point<double>& a, const Point<double>& b) {
+        return a.x == b.x && a.y == b.y;
+    }
+
+    Expansion cross(const Point<double>& a, const Point<double>& b) {
+        return sum(product({a.x}, {b.y}), negate(product({a.y}, {b.x})));
+    }
+
+    Expansion sqrlen(const Point<double>& a) {
+        return sum(product({a.x}, {a.x}), product({a.y}, {a.y}));
+    }
+
+    // Sign of det(a, b, c). The error bound of the double evaluation decides
+    // almost every call, the rest are recomputed exactly.
+    int orientation(const Point<double>& a, const Point<double>& b, const Point<double>& c) {
+        static const double kErrBound = (3 + 16 * kEpsilon) * kEpsilon;
+        double left = (b.x - a.x) * (c.y - a.y);
+        double right = (c.x - a.x) * (b.y - a.y);
+        double d = left - right;
+        if (fabs(d) > kErrBound * (fabs(left) + fabs(right))) {
+            return d > 0 ? 1 : -1;
+        }
+        if (same(a, b) || same(b, c) || same(c, a))
+            return 0;
+        // det(a, b, c) = cross(a, b) + cross(b, c) + cross(c, a).
+        return sign(sum(sum(cross(a, b), cross(b, c)), cross(c, a)));
+    }
+
+    int incircle(const Point<double>& a, const Point<double>& b,
+        const Point<double>& c, const Point<double>& d) {
+        static const double kErrBound = (10 + 96 * kEpsilon) * kEpsilon;
+        double adx = a.x - d.x, ady = a.y - d.y;
+        double bdx = b.x - d.x, bdy = b.y - d.y;
+        double cdx = c.x - d.x, cdy = c.y - d.y;
+        double bc = bdx * cdy, cb = cdx * bdy;
+        double ca = cdx * ady, ac = adx * cdy;
+        double ab = adx * bdy, ba = bdx * ady;
+        double alift = adx * adx + ady * ady;
+        double blift = bdx * bdx + bdy * bdy;
+        double clift = cdx * cdx + cdy * cdy;
+        double det = alift * (bc - cb) + blift * (ca - ac) + clift * (ab - ba);
+        double permanent = (fabs(bc) + fabs(cb)) * alift
+                         + (fabs(ca) + fabs(ac)) * blift
+                         + (fabs(ab) + fabs(ba)) * clift;
+        if (fabs(det) > kErrBound * permanent) {
+            return det > 0 ? 1 : -1;
+        }
+        if (same(d, a) || same(d, b) || same(d, c))
+            return 0;
+
+        // Translating by d is not exact, so expand the lifted 4x4 determinant
+        // over the original coordinates instead.
+        auto minor = [](const Point<double>& p, const Point<double>& q, const Point<double>& r) {
+            Expansion e = product(sqrlen(p), cross(q, r));
+            e = sum(e, negate(product(sqrlen(q), cross(p, r))));
+            return sum(e, product(sqrlen(r), cross(p, q)));
+        };
+        Expansion e = sum(minor(a, c, d), minor(a, b, c));
+        e = sum(e, negate(sum(minor(b, c, d), minor(a, b, d))));
+        return sign(e);
+    }
+
+    // Rounded value of an expansion.
+    double estimate(const Expansion& e) {
+        double s = 0;
+        for (double c : e) {
+            s += c;
+        }
+        return s;
+    }
+
+    Expansion difference(double a, double b) {
+        return grow({a}, -b);
+    }
+
+    // The point (xn / den, yn / den) with den > 0. (x, y) approximates it
+    // within err in each coordinate, err is 0 exactly for input points.
+    struct RationalPoint {
+        Expansion xn, yn, den;
+        double x, y, err;
+    };
+
+    RationalPoint rational(const Point<double>& p) {
+        return {{p.x}, {p.y}, {1}, p.x, p.y, 0};
+    }
+
+    // Intersection of segments ab and cd, which must cross in a single point.
+    RationalPoint lineIntersection(const Point<double>& a, const Point<double>& b,
+        const Point<double>& c, const Point<double>& d) {
+        Expansion abx = difference(b.x, a.x), aby = difference(b.y, a.y);
+        Expansion cdx = difference(d.x, c.x), cdy = difference(d.y, c.y);
+        Expansion acx = difference(c.x, a.x), acy = difference(c.y, a.y);
+        Expansion tn = sum(product(acx, cdy), negate(product(acy, cdx)));
+        Expansion td = sum(product(abx, cdy), negate(product(aby, cdx)));
+        if (sign(td) < 0) {
+            tn = negate(tn);
+            td = negate(td);
+        }
+        RationalPoint p;
+        p.xn = sum(product({a.x}, td), product(abx, tn));
+        p.yn = sum(product({a.y}, td), product(aby, tn));
+        p.den = td;
+        // The parameter along ab is in [0, 1], so the rounding error of the
+        // approximation is a few ulps of the largest coordinate.
+        double t = estimate(tn) / estimate(td);
+        p.x = a.x + (b.x - a.x) * t;
+        p.y = a.y + (b.y - a.y) * t;
+        p.err = 1e-12 * (fabs(a.x) + fabs(b.x) + fabs(a.y) + fabs(b.y));
+        return p;
+    }
+
+    // Compares pn / pd with qn / qd, which are pa within pe and qa within qe.
+    int compare(const Expansion& pn, const Expansion& pd, double pa, double pe,
+        const Expansion& qn, const Expansion& qd, double qa, double qe) {
+        if (pa + pe < qa - qe)
+            return -1;
+        if (pa - pe > qa + qe)
+            return 1;
+        if (pe == 0 && qe == 0)
+            return 0;
+        return sign(sum(product(pn, qd), negate(product(qn, pd))));
+    }
+
+    // Lexicographic comparison.
+    int compare(const RationalPoint& p, const RationalPoint& q) {
+        int c = compare(p.xn, p.den, p.x, p.err, q.xn, q.den, q.x, q.err);
+        return c != 0 ? c : compare(p.yn, p.den, p.y, p.err, q.yn, q.den, q.y, q.err);
+    }
+
+    // Sign of det(a, b, p).
+    int orientation(const Point<double>& a, const Point<double>& b, const RationalPoint& p) {
+        if (p.err == 0)
+            return orientation(a, b, Point<double>(p.x, p.y));
+        double ux = b.x - a.x, uy = b.y - a.y;
+        double d = ux * (p.y - a.y) - (p.x - a.x) * uy;
+        double bound = 1.01 * (fabs(ux) + fabs(uy)) * p.err
+            + 1e-14 * (fabs(ux) * (fabs(p.y) + fabs(a.y)) + (fabs(p.x) + fabs(a.x)) * fabs(uy));
+        if (fabs(d) > bound) {
+            return d > 0 ? 1 : -1;
+        }
+        Expansion px = sum(p.xn, negate(product({a.x}, p.den)));
+        Expansion py = sum(p.yn, negate(product({a.y}, p.den)));
+        return sign(sum(product(difference(b.x, a.x), py), negate(product(px, difference(b.y, a.y)))));
+    }
 }
 
-T sqrdist(const Point& a, const Point& b) {
-    return (b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y);
+// Sign of det(a, b, c). Exact for double and integer coordinates;
+// other floating point types just use the sign of det.
+template<typename T>
+int orientation(const Point<T>& a, const Point<T>& b, const Point<T>& c) {
+    if constexpr (is_same<T, double>::value) {
+        return exact::orientation(a, b, c);
+    } else {
+        Wide<T> d = det(a, b, c);
+        return (d > 0) - (d < 0);
+    }
 }
 
-T dist(const Point& a, const Point& b) {
-    return sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+// Returns 1 if d lies strictly inside the circle through a, b, c (given in
+// counterclockwise order), -1 if strictly outside and 0 if on it.
+// Exact for double coordinates and for integer ones below 2^53.
+template<typename T>
+int incircle(const Point<T>& a, const Point<T>& b, const Point<T>& c, const Point<T>& d) {
+    auto conv = [](const Point<T>& p) {
+        return Point<double>(p.x, p.y);
+    };
+    return exact::incircle(conv(a), conv(b), conv(c), conv(d));
 }
 
-bool colinear(const Point& a, const Point& b, const Point& c) {
-    return fabs(det(a, b, c)) < EPS;
+template<typename T>
+bool colinear(const Point<T>& a, const Point<T>& b, const Point<T>& c) {
+    return orientation(a, b, c) == 0;
 }
 
 // Clockwise turn through b.
-bool CW(const Point& a, const Point& b, const Point& c) {
-    return det(a, b, c) < 0;
+template<typename T>
+bool CW(const Point<T>& a, const Point<T>& b, const Point<T>& c) {
+    return orientation(a, b, c) < 0;
 }
 
 // Counterclockwise turn through b.
-bool CCW(const Point& a, const Point& b, const Point& c) {
-    return det(a, b, c) > 0;
+template<typename T>
+bool CCW(const Point<T>& a, const Point<T>& b, const Point<T>& c) {
+    return orientation(a, b, c) > 0;
 }
 
 // Right angle in b.
-bool right(const Point& a, const Point& b, const Point& c) {
-    return fabs(dot(a - b, c - b)) < EPS;
+template<typename T>
+bool right(const Point<T>& a, const Point<T>& b, const Point<T>& c) {
+    return equal(dot(a - b, c - b), Wide<T>(0));
 }
 
 // Acute angle in b.
-bool acute(const Point& a, const Point& b, const Point& c) {
+template<typename T>
+bool acute(const Point<T>& a, const Point<T>& b, const Point<T>& c) {
     return dot(a - b, c - b) > 0;
 }
 
 // Obtuse angle in b.
-bool obtuse(const Point& a, const Point& b, const Point& c) {
+template<typename T>
+bool obtuse(const Point<T>& a, const Point<T>& b, const Point<T>& c) {
     return dot(a - b, c - b) < 0;
 }
 
 // Returns points on the convex hull in counterclocwise order.
 // keep_colinear: boolean, if true keeps colinear points.
-vector<Point> ConvexHull(vector<Point> v, bool keep_colinear=false) {
-    sort(v.begin(), v.end());
-    vector<Point> ch;
+template<typename T>
+vector<Point<T>> ConvexHull(vector<Point<T>> v, bool keep_colinear=false) {
+    // Exact lexicographic order, the turns below are exact as well.
+    sort(v.begin(), v.end(), [](const Point<T>& p, const Point<T>& q) {
+        return tie(p.x, p.y) < tie(q.x, q.y);
+    });
+    vector<Point<T>> ch;
 
     vector<int> st(v.size());
     int k = 0;
 
     auto place = [&](int i) {
-        while(k > 1 && (CW(v[st[k-2]], v[st[k-1]], v[i]) || 
+        while(k > 1 && (CW(v[st[k-2]], v[st[k-1]], v[i]) ||
             (!keep_colinear && colinear(v[st[k-2]], v[st[k-1]], v[i]))))
             --k;
         st[k++] = i;
@@ -182,85 +615,447 @@ vector<Point> ConvexHull(vector<Point> v, bool keep_colinear=false) {
     return ch;
 }
 
+// Calls f(from, to) on consecutive ranges covering [0, n), one per thread.
+template<typename F>
+void parallelRanges(int n, int threads, const F& f) {
+    threads = max(1, min(threads, n));
+    int chunk = (n + threads - 1) / threads;
+    vector<thread> pool;
+    for (int k = 1; k < threads; ++k) {
+        int from = min(n, k * chunk), to = min(n, from + chunk);
+        if (from < to)
+            pool.emplace_back(f, from, to);
+    }
+    if (n > 0)
+        f(0, min(n, chunk));
+    for (thread& t : pool) {
+        t.join();
+    }
+}
+
+// Akl-Toussaint heuristic: returns the points of batch that are not strictly
+// inside the polygon spanned by the extreme points in 8 directions. For random
+// inputs that leaves a tiny fraction of the points, without sorting anything.
+template<typename T>
+vector<Point<T>> AklToussaint(const PointBatch<T>& batch, int threads=1) {
+    typedef Wide<T> W;
+    int n = batch.size();
+    if (n == 0)
+        return {};
+    int ext[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    auto key = [&](int dir, int i) -> W {
+        W x = batch.x[i], y = batch.y[i];
+        switch (dir & 3) {
+            case 0: return x;
+            case 1: return y;
+            case 2: return x + y;
+            default: return x - y;
+        }
+    };
+    for (int i = 1; i < n; ++i) {
+        for (int dir = 0; dir < 8; ++dir) {
+            if (dir < 4 ? key(dir, i) < key(dir, ext[dir]) : key(dir, i) > key(dir, ext[dir]))
+                ext[dir] = i;
+        }
+    }
+    vector<Point<T>> corners;
+    for (int dir = 0; dir < 8; ++dir) {
+        corners.push_back(batch[ext[dir]]);
+    }
+    vector<Point<T>> q = ConvexHull(corners);
+    if (q.size() < 3) {
+        vector<Point<T>> all(n);
+        for (int i = 0; i < n; ++i) {
+            all[i] = batch[i];
+        }
+        return all;
+    }
+
+    // A point is dropped when every edge of q certainly sees it on the left.
+    // For double that means det clears the orientation error bound, taken
+    // over the whole bounding box so the batch kernel can be used as is.
+    vector<W> thr(q.size(), 0);
+    if constexpr (is_same<T, double>::value) {
+        double spanx = batch.x[ext[4]] - batch.x[ext[0]];
+        double spany = batch.y[ext[5]] - batch.y[ext[1]];
+        double bound = 1.01 * (3 + 16 * exact::kEpsilon) * exact::kEpsilon;
+        for (int j = 0; j < q.size(); ++j) {
+            Point<T> u = q[(j + 1) % q.size()] - q[j];
+            thr[j] = bound * (fabs(u.x) * spany + fabs(u.y) * spanx);
+        }
+    }
+
+    const int kBlock = 1024;
+    int blocks = (n + kBlock - 1) / kBlock;
+    vector<vector<Point<T>>> kept(blocks);
+    parallelRanges(blocks, threads, [&](int fromBlock, int toBlock) {
+        W d[kBlock];
+        bool inside[kBlock];
+        for (int blk = fromBlock; blk < toBlock; ++blk) {
+            int from = blk * kBlock, to = min(n, from + kBlock);
+            fill(inside, inside + (to - from), true);
+            for (int j = 0; j < q.size(); ++j) {
+                BatchDet(q[j], q[(j + 1) % q.size()], batch, from, to, d);
+                for (int i = 0; i < to - from; ++i) {
+                    inside[i] &= d[i] > thr[j];
+                }
+            }
+            for (int i = from; i < to; ++i) {
+                if (!inside[i - from])
+                    kept[blk].push_back(batch[i]);
+            }
+        }
+    });
+
+    vector<Point<T>> res;
+    for (const vector<Point<T>>& part : kept) {
+        res.insert(res.end(), part.begin(), part.end());
+    }
+    return res;
+}
+
+// Convex hull of a large point set: Akl-Toussaint prefilter, then with
+// threads > 1 the survivors are split into chunks whose hulls are built in
+// parallel and merged by one more monotone chain over their vertices.
+// Same output as ConvexHull(vector<Point<T>>).
+template<typename T>
+vector<Point<T>> ConvexHull(const PointBatch<T>& batch, bool keep_colinear=false, int threads=1) {
+    const int kParallel = 1<<16;
+    vector<Point<T>> v = AklToussaint(batch, threads);
+    if (threads <= 1 || v.size() < kParallel)
+        return ConvexHull(move(v), keep_colinear);
+
+    vector<vector<Point<T>>> hulls(threads);
+    int chunk = (v.size() + threads - 1) / threads;
+    parallelRanges(v.size(), threads, [&](int from, int to) {
+        hulls[from / chunk] = ConvexHull(vector<Point<T>>(v.begin() + from, v.begin() + to), keep_colinear);
+    });
+    vector<Point<T>> merged;
+    for (const vector<Point<T>>& h : hulls) {
+        merged.insert(merged.end(), h.begin(), h.end());
+    }
+    return ConvexHull(move(merged), keep_colinear);
+}
+
+// Chan's algorithm, O(n log h) for a hull with h vertices. Returns the hull
+// vertices in counterclockwise order starting from the smallest point, like
+// ConvexHull, without colinear points. Beats the monotone chain when h is
+// a few dozen vertices; the prefiltered batch ConvexHull is faster still
+// on random inputs.
+template<typename T>
+vector<Point<T>> ChanHull(const vector<Point<T>>& v) {
+    int n = v.size();
+    if (n <= 2)
+        return ConvexHull(v);
+
+    // Whether r is a better next hull vertex than q, seen from p.
+    auto better = [](const Point<T>& p, const Point<T>& q, const Point<T>& r) {
+        int o = orientation(p, q, r);
+        return o < 0 || (o == 0 && sqrdist(p, r) > sqrdist(p, q));
+    };
+
+    // Best vertex of the convex polygon h seen from p, by binary search
+    // on the directions of its edges.
+    auto tangent = [&](const vector<Point<T>>& h, const Point<T>& p) {
+        int m = h.size();
+        auto at = [&](int i) -> const Point<T>& {
+            return h[(i % m + m) % m];
+        };
+        auto up = [&](int i) {
+            return orientation(p, at(i), at(i + 1)) < 0;
+        };
+        auto top = [&](int i) {
+            return !up(i) && up(i - 1);
+        };
+        int best = -1;
+        if (m >= 8) {
+            if (top(0)) {
+                best = 0;
+            }
+            int a = 0, b = m;
+            while (best == -1 && b - a > 1) {
+                int c = (a + b) / 2;
+                if (top(c)) {
+                    best = c;
+                } else if (up(a)) {
+                    if (!up(c) || !better(p, at(a), at(c)))
+                        b = c;
+                    else
+                        a = c;
+                } else {
+                    if (up(c) || !better(p, at(a), at(c)))
+                        a = c;
+                    else
+                        b = c;
+                }
+            }
+        }
+        if (best == -1) {
+            best = 0;
+            for (int i = 1; i < m; ++i) {
+                if (better(p, h[best], h[i]))
+                    best = i;
+            }
+            return best;
+        }
+        // Colinear neighbours of the top, take the farthest one.
+        for (int i : {best - 1, best + 1}) {
+            if (better(p, at(best), at(i)))
+                best = (i + m) % m;
+        }
+        return best;
+    };
+
+    int start = min_element(v.begin(), v.end(), [](const Point<T>& p, const Point<T>& q) {
+        return tie(p.x, p.y) < tie(q.x, q.y);
+    }) - v.begin();
+
+    // Group sizes 2^(2^t), starting at 256: smaller groups only add rounds.
+    for (int t = 3; ; ++t) {
+        int m = t < 5 ? min(n, 1 << (1 << t)) : n;
+        if (m == n)
+            return ConvexHull(v);
+
+        vector<vector<Point<T>>> groups;
+        int cur = -1, idx = 0;
+        for (int from = 0; from < n; from += m) {
+            int to = min(n, from + m);
+            if (from <= start && start < to)
+                cur = groups.size();
+            groups.push_back(ConvexHull(vector<Point<T>>(v.begin() + from, v.begin() + to)));
+        }
+        while (tie(groups[cur][idx].x, groups[cur][idx].y) != tie(v[start].x, v[start].y))
+            ++idx;
+
+        vector<Point<T>> hull = {v[start]};
+        for (int step = 0; step < m; ++step) {
+            const Point<T>& p = groups[cur][idx];
+            int nextGroup = cur, nextIdx = (idx + 1) % groups[cur].size();
+            for (int g = 0; g < groups.size(); ++g) {
+                if (g == cur)
+                    continue;
+                int i = tangent(groups[g], p);
+                if (better(p, groups[nextGroup][nextIdx], groups[g][i])) {
+                    nextGroup = g;
+                    nextIdx = i;
+                }
+            }
+            cur = nextGroup;
+            idx = nextIdx;
+            const Point<T>& q = groups[cur][idx];
+            if (tie(q.x, q.y) == tie(v[start].x, v[start].y))
+                return hull;
+            hull.push_back(q);
+        }
+    }
+}
+
 // Project point p onto line formed by a and b.
-Point ProjectPointLine(const Point& p, const Point& a, const Point& b) {
-    Point ab = b - a;
+template<typename T>
+Point<T> ProjectPointLine(const Point<T>& p, const Point<T>& a, const Point<T>& b) {
+    Point<T> ab = b - a;
     return a + ab * dot(p - a, ab) / ab.sqrlen();
 }
 
 // Project point p onto segment formed by a and b.
-Point ProjectPointSegment(const Point& p, const Point& a, const Point& b) {
+template<typename T>
+Point<T> ProjectPointSegment(const Point<T>& p, const Point<T>& a, const Point<T>& b) {
     if (a == b)
         return a;
-    Point ab = b - a;
+    Point<T> ab = b - a;
     T coef = dot(p - a, ab) / ab.sqrlen();
     if (coef < 0) return a;
     if (coef > 1) return b;
     return a + ab * coef;
 }
 
-T DistancePointLine(const Point& p, const Point& a, const Point& b) {
+template<typename T>
+T DistancePointLine(const Point<T>& p, const Point<T>& a, const Point<T>& b) {
     return dist(p, ProjectPointLine(p, a, b));
 }
 
-T DistancePointSegment(const Point& p, const Point& a, const Point& b) {
+template<typename T>
+T DistancePointSegment(const Point<T>& p, const Point<T>& a, const Point<T>& b) {
     return dist(p, ProjectPointSegment(p, a, b));
 }
 
 // Checks if lines ab and cd are parallel
-bool LinesParallel(const Point& a, const Point& b, const Point& c, const Point& d) {
-    return fabs(cross(b - a, c - d)) < EPS;
+template<typename T>
+bool LinesParallel(const Point<T>& a, const Point<T>& b, const Point<T>& c, const Point<T>& d) {
+    return equal(cross(b - a, c - d), Wide<T>(0));
 }
 
 // Checks if lines ab and cd are colinear.
-bool LinesColinear(const Point& a, const Point& b, const Point& c, const Point& d) {
+template<typename T>
+bool LinesColinear(const Point<T>& a, const Point<T>& b, const Point<T>& c, const Point<T>& d) {
     return colinear(a, b, c) && colinear(a, b, d);
 }
 
 // Returns if c and d are strictly on the same side of line passing through a and b.
-bool OnSameSide(const Point& a, const Point& b, const Point& c, const Point& d) {
+template<typename T>
+bool OnSameSide(const Point<T>& a, const Point<T>& b, const Point<T>& c, const Point<T>& d) {
     return CW(a, b, c) && CW(a, b, d) || CCW(a, b, c) && CCW(a, b, d);
 }
 
 // Determine if segments ab and ac intersect.
-bool SegmentsIntersect(const Point& a, const Point& b, const Point& c, const Point& d) {
-    if (LinesColinear(a, b, c, d)) {
-        if (a == c || a == d || b == c || b == d)
-            return true;
-        if (obtuse(a, b, c) && obtuse(a, b, d) ||
-            obtuse(b, a, c) && obtuse(b, a, d))
-            return false;
+template<typename T>
+bool SegmentsIntersect(const Point<T>& a, const Point<T>& b, const Point<T>& c, const Point<T>& d) {
+    // Whether p, known to be colinear with segment qr, lies on it.
+    auto within = [](const Point<T>& p, const Point<T>& q, const Point<T>& r) {
+        return min(q.x, r.x) <= p.x && p.x <= max(q.x, r.x) &&
+               min(q.y, r.y) <= p.y && p.y <= max(q.y, r.y);
+    };
+    int abc = orientation(a, b, c), abd = orientation(a, b, d);
+    int cda = orientation(c, d, a), cdb = orientation(c, d, b);
+    if (abc * abd < 0 && cda * cdb < 0)
         return true;
-    }
-    if (OnSameSide(a, b, c, d) || OnSameSide(c, d, a, b)) 
-        return false;
-    return true;
+    return (abc == 0 && within(c, a, b)) || (abd == 0 && within(d, a, b)) ||
+           (cda == 0 && within(a, c, d)) || (cdb == 0 && within(b, c, d));
 }
 
 // Returns a tuple of (a, b, c) where a*x + b*y + c = 0 is the line's implicit equation.
-tuple<T, T, T> LineEquation(const Point& a, const Point& b) {
+template<typename T>
+tuple<Wide<T>, Wide<T>, Wide<T>> LineEquation(const Point<T>& a, const Point<T>& b) {
     assert(a != b);
-    Point ort = (b - a).rotateCCW90();
-    T c = -cross(a, b);
-    return make_tuple(ort.x, ort.y, c);
+    Point<T> ort = (b - a).rotateCCW90();
+    Wide<T> c = -cross(a, b);
+    return make_tuple(Wide<T>(ort.x), Wide<T>(ort.y), c);
 }
 
-vector<Point> LineIntersection(const Point& a, const Point& b, const Point& c, const Point& d) {
+template<typename T>
+vector<Point<T>> LineIntersection(const Point<T>& a, const Point<T>& b, const Point<T>& c, const Point<T>& d) {
     if(LinesParallel(a, b, c, d) || a == b || c == d)
         return {};
-    Point ab = b - a; 
-    Point dc = c - d; 
-    Point ac = c - a;
+    Point<T> ab = b - a;
+    Point<T> dc = c - d;
+    Point<T> ac = c - a;
     return {a + ab * cross(ac, dc) / cross(ab, dc)};
 }
 
+// Bentley-Ottmann sweep over the segments, O((n + k) log n) for k reported
+// points. Calls report(p, ids) for every point where two or more segments
+// meet, in lexicographic order, with the indices of all segments through it.
+// p is within a few ulps of the exact point, as it is rounded from the
+// exact rational one by floating-point division. Events are ordered and
+// placed with those exact rational intersections, so nothing is missed or
+// duplicated.
+// Colinear overlaps are reported at the endpoints lying on the other
+// segment. Integer coordinates must be below 2^53 in absolute value.
+template<typename T, typename F>
+void SegmentIntersections(const vector<pair<Point<T>, Point<T>>>& segments, const F& report) {
+    typedef Point<double> P;
+    typedef exact::RationalPoint R;
+    int n = segments.size();
+    vector<P> a(n), b(n);
+    for (int i = 0; i < n; ++i) {
+        a[i] = P(segments[i].first.x, segments[i].first.y);
+        b[i] = P(segments[i].second.x, segments[i].second.y);
+        if (tie(b[i].x, b[i].y) < tie(a[i].x, a[i].y))
+            swap(a[i], b[i]);
+    }
+
+    // Event points, with the segments starting at each.
+    auto eventLess = [](const R& p, const R& q) {
+        return exact::compare(p, q) < 0;
+    };
+    map<R, vector<int>, decltype(eventLess)> events(eventLess);
+    for (int i = 0; i < n; ++i) {
+        events[exact::rational(a[i])].push_back(i);
+        events[exact::rational(b[i])];
+    }
+
+    // Sweep status, bottom to top just after the current event p. Every
+    // comparison involves either the probe for p itself or the segment being
+    // inserted, which passes through p; segments through p are ordered by
+    // their direction after it.
+    const int kProbe = -1;
+    const R* p = nullptr;
+    int key = kProbe;
+    auto below = [&](int i, int j) {
+        if (i == j)
+            return false;
+        if (i == kProbe)
+            return exact::orientation(a[j], b[j], *p) < 0;
+        if (j == kProbe)
+            return exact::orientation(a[i], b[i], *p) > 0;
+        int k = i == key ? i : j, o = i == key ? j : i;
+        int side = exact::orientation(a[o], b[o], *p);
+        if (side == 0)
+            side = exact::orientation(a[o], b[o], b[k]);
+        bool kBelow = side != 0 ? side < 0 : k < o;
+        return i == k ? kBelow : !kBelow;
+    };
+    set<int, decltype(below)> status(below);
 
-vector<Point> LineCircleIntersection(const Point& a, const Point& b, const Point& c, const T& r) {
-    Point ab = b - a;
+    // Schedules the crossing of neighbours s and t if it is after p.
+    auto check = [&](int s, int t) {
+        if (!SegmentsIntersect(a[s], b[s], a[t], b[t]))
+            return;
+        if (exact::orientation(a[s], b[s], a[t]) == 0 && exact::orientation(a[s], b[s], b[t]) == 0)
+            return;
+        R q = exact::lineIntersection(a[s], b[s], a[t], b[t]);
+        if (exact::compare(q, *p) > 0)
+            events.emplace(q, vector<int>());
+    };
+
+    vector<int> ids, inserted;
+    while (!events.empty()) {
+        R cur = events.begin()->first;
+        vector<int> starts = move(events.begin()->second);
+        events.erase(events.begin());
+        p = &cur;
+        key = kProbe;
+
+        // Segments in the status through p are contiguous. The ones not
+        // ending at p are reinserted below, in their order after p.
+        ids.clear();
+        inserted.clear();
+        auto it = status.lower_bound(kProbe);
+        while (it != status.end() && exact::orientation(a[*it], b[*it], cur) == 0) {
+            int s = *it;
+            it = status.erase(it);
+            ids.push_back(s);
+            if (exact::compare(exact::rational(b[s]), cur) != 0)
+                inserted.push_back(s);
+        }
+        for (int s : starts) {
+            ids.push_back(s);
+            if (tie(a[s].x, a[s].y) != tie(b[s].x, b[s].y))
+                inserted.push_back(s);
+        }
+        if (ids.size() > 1)
+            report(P(cur.x, cur.y), ids);
+
+        for (int s : inserted) {
+            key = s;
+            status.insert(s);
+        }
+        key = kProbe;
+
+        auto lo = status.lower_bound(kProbe);
+        if (inserted.empty()) {
+            if (lo != status.begin() && lo != status.end())
+                check(*prev(lo), *lo);
+        } else {
+            auto hi = lo;
+            while (next(hi) != status.end() && exact::orientation(a[*next(hi)], b[*next(hi)], cur) == 0)
+                ++hi;
+            if (lo != status.begin())
+                check(*prev(lo), *lo);
+            if (next(hi) != status.end())
+                check(*hi, *next(hi));
+        }
+    }
+}
+
+
+template<typename T>
+vector<Point<T>> LineCircleIntersection(const Point<T>& a, const Point<T>& b, const Point<T>& c, const T& r) {
+    Point<T> ab = b - a;
     ab.normalize();
-    Point ac = c - a;
+    Point<T> ac = c - a;
     T distCenterLine = cross(ab, ac);
-    Point lineMid = c + ab.rotateCCW90() * distCenterLine;
+    Point<T> lineMid = c + ab.rotateCCW90() * distCenterLine;
     if (r < distCenterLine) {
         return {};
     }
@@ -271,8 +1066,9 @@ vector<Point> LineCircleIntersection(const Point& a, const Point& b, const Point
     return {lineMid};
 }
 
-vector<Point> CircleIntersection(const Point& a, T r, const Point& b, T R) {
-    Point ab = b - a;
+template<typename T>
+vector<Point<T>> CircleIntersection(const Point<T>& a, T r, const Point<T>& b, T R) {
+    Point<T> ab = b - a;
     T d = ab.len();
     if (d > r + R || d + min(r, R) <= max(r, R)){
         return {};
@@ -280,17 +1076,868 @@ vector<Point> CircleIntersection(const Point& a, T r, const Point& b, T R) {
     T aHeight = (d * d - R * R + r * r) / (2 * d);
     T expandFromMid = sqrt(r * r - aHeight * aHeight);
     ab.normalize();
-    Point lineMid = a + ab * aHeight;
-    Point perpab = ab.rotateCCW90();
+    Point<T> lineMid = a + ab * aHeight;
+    Point<T> perpab = ab.rotateCCW90();
     if (expandFromMid > EPS) {
         return {lineMid + perpab * expandFromMid, lineMid - perpab * expandFromMid};
     }
     return {lineMid};
 }
 
+// Whether direction u comes before v counterclockwise from the positive
+// x axis, angles in [0, 2pi). Exact, directions must be nonzero.
+template<typename T>
+bool AngleLess(const Point<T>& u, const Point<T>& v) {
+    auto half = [](const Point<T>& p) {
+        return p.y < 0 || (p.y == 0 && p.x < 0);
+    };
+    if (half(u) != half(v))
+        return half(u) < half(v);
+    return orientation(Point<T>(0, 0), u, v) > 0;
+}
+
+// Intersection of the half-planes to the left of the directed lines
+// h[i].first -> h[i].second, as a counterclockwise polygon. Empty if the
+// intersection is empty or degenerate. The result must be bounded, add the
+// sides of a large box if it might not be. O(n log n), floating point T.
+template<typename T>
+vector<Point<T>> HalfPlaneIntersection(vector<pair<Point<T>, Point<T>>> h) {
+    typedef pair<Point<T>, Point<T>> Line;
+    // Only the sign of det, so short direction vectors work as well as
+    // long ones.
+    auto out = [](const Line& l, const Point<T>& p) {
+        return det(l.first, l.second, p) < 0;
+    };
+    // Neighbours in the deque are never parallel, the loop below drops one
+    // of two colinear directions first.
+    auto meet = [](const Line& l, const Line& m) {
+        Point<T> u = l.second - l.first, v = m.second - m.first;
+        return l.first + u * (cross(m.first - l.first, v) / cross(u, v));
+    };
+    sort(h.begin(), h.end(), [](const Line& l, const Line& m) {
+        return AngleLess(l.second - l.first, m.second - m.first);
+    });
+
+    vector<Line> dq(h.size());
+    int front = 0, back = 0;
+    for (const Line& l : h) {
+        while (back - front > 1 && out(l, meet(dq[back - 1], dq[back - 2])))
+            --back;
+        while (back - front > 1 && out(l, meet(dq[front], dq[front + 1])))
+            ++front;
+        if (back - front > 0 && colinear(Point<T>(0, 0), l.second - l.first,
+                dq[back - 1].second - dq[back - 1].first)) {
+            // Opposite directions next to each other leave nothing.
+            if (dot(l.second - l.first, dq[back - 1].second - dq[back - 1].first) < 0)
+                return {};
+            // Same direction, keep the more restrictive one.
+            if (!out(l, dq[back - 1].first))
+                continue;
+            --back;
+        }
+        dq[back++] = l;
+    }
+    while (back - front > 2 && out(dq[front], meet(dq[back - 1], dq[back - 2])))
+        --back;
+    while (back - front > 2 && out(dq[back - 1], meet(dq[front], dq[front + 1])))
+        ++front;
+    if (back - front < 3)
+        return {};
+
+    vector<Point<T>> res;
+    for (int i = front; i < back; ++i) {
+        res.push_back(meet(dq[i], dq[i + 1 < back ? i + 1 : front]));
+    }
+    return res;
+}
+
+// Minkowski sum of convex polygons in counterclockwise order without
+// colinear points, O(n + m). Exact for integer coordinates.
+template<typename T>
+vector<Point<T>> MinkowskiSum(vector<Point<T>> p, vector<Point<T>> q) {
+    auto lowest = [](vector<Point<T>>& v) {
+        rotate(v.begin(), min_element(v.begin(), v.end(), [](const Point<T>& a, const Point<T>& b) {
+            return tie(a.y, a.x) < tie(b.y, b.x);
+        }), v.end());
+    };
+    if (p.empty() || q.empty())
+        return {};
+    lowest(p);
+    lowest(q);
+    int n = p.size(), m = q.size();
+    p.push_back(p[0]);
+    p.push_back(p[1 % n]);
+    q.push_back(q[0]);
+    q.push_back(q[1 % m]);
+
+    vector<Point<T>> res;
+    int i = 0, j = 0;
+    while (i < n || j < m) {
+        res.push_back(p[i] + q[j]);
+        Wide<T> c = cross(p[i + 1] - p[i], q[j + 1] - q[j]);
+        if (c >= 0 && i < n)
+            ++i;
+        if (c <= 0 && j < m)
+            ++j;
+    }
+    return res;
+}
+
+// Rotating calipers. The functions below take a convex polygon in
+// counterclockwise order without colinear points, as ConvexHull returns.
+
+// Indices of a farthest pair of vertices, O(n). Exact for integer coordinates.
+template<typename T>
+pair<int, int> Diameter(const vector<Point<T>>& h) {
+    int n = h.size();
+    if (n < 3)
+        return {0, n - 1};
+    pair<int, int> best = {0, 0};
+    Wide<T> bestDist = 0;
+    auto consider = [&](int i, int j) {
+        Wide<T> d = sqrdist(h[i], h[j]);
+        if (d > bestDist) {
+            bestDist = d;
+            best = {i, j};
+        }
+    };
+    for (int i = 0, j = 1; i < n; ++i) {
+        int ni = (i + 1) % n;
+        while (cross(h[ni] - h[i], h[(j + 1) % n] - h[j]) > 0)
+            j = (j + 1) % n;
+        consider(i, j);
+        consider(ni, j);
+    }
+    return best;
+}
+
+// Smallest distance between two parallel lines enclosing the polygon, O(n).
+template<typename T>
+Real<T> Width(const vector<Point<T>>& h) {
+    int n = h.size();
+    if (n < 3)
+        return 0;
+    Real<T> best = numeric_limits<Real<T>>::infinity();
+    for (int i = 0, j = 1; i < n; ++i) {
+        int ni = (i + 1) % n;
+        while (det(h[i], h[ni], h[(j + 1) % n]) > det(h[i], h[ni], h[j]))
+            j = (j + 1) % n;
+        best = min(best, (Real<T>)det(h[i], h[ni], h[j]) / dist(h[i], h[ni]));
+    }
+    return best;
+}
+
+// Corners of a minimum-area enclosing rectangle in counterclockwise order.
+// One of its sides contains a polygon edge, so the calipers try each, O(n).
+template<typename T>
+vector<Point<Real<T>>> MinAreaRectangle(const vector<Point<T>>& poly) {
+    typedef Real<T> R;
+    int n = poly.size();
+    vector<Point<R>> h(n);
+    for (int i = 0; i < n; ++i) {
+        h[i] = Point<R>(poly[i].x, poly[i].y);
+    }
+    if (n < 3) {
+        if (n == 0)
+            return {};
+        return {h[0], h[n - 1], h[n - 1], h[0]};
+    }
+
+    vector<Point<R>> best;
+    R bestArea = numeric_limits<R>::infinity();
+    int far = 1, right = 1, left = -1;
+    for (int i = 0; i < n; ++i) {
+        int ni = (i + 1) % n;
+        Point<R> e = h[ni] - h[i];
+        auto next = [&](int k) {
+            return h[(k + 1) % n] - h[k];
+        };
+        while (cross(e, next(far)) > 0)
+            far = (far + 1) % n;
+        while (dot(e, next(right)) > 0)
+            right = (right + 1) % n;
+        if (left == -1)
+            left = far;
+        while (dot(e, next(left)) < 0)
+            left = (left + 1) % n;
+
+        R len = e.len();
+        Point<R> u = e / len, v = u.rotateCCW90();
+        R lo = dot(u, h[left] - h[i]), hi = dot(u, h[right] - h[i]);
+        R height = cross(u, h[far] - h[i]);
+        if ((hi - lo) * height < bestArea) {
+            bestArea = (hi - lo) * height;
+            best = {h[i] + u * lo, h[i] + u * hi, h[i] + u * hi + v * height, h[i] + u * lo + v * height};
+        }
+    }
+    return best;
+}
+
+// Returns 1 if p is strictly inside the convex polygon h, 0 if on its
+// boundary and -1 if outside, O(log n). Exact.
+template<typename T>
+int PointInConvexPolygon(const vector<Point<T>>& h, const Point<T>& p) {
+    int n = h.size();
+    auto on = [&](const Point<T>& a, const Point<T>& b) {
+        return orientation(a, b, p) == 0 &&
+            min(a.x, b.x) <= p.x && p.x <= max(a.x, b.x) &&
+            min(a.y, b.y) <= p.y && p.y <= max(a.y, b.y);
+    };
+    if (n < 3)
+        return n > 0 && on(h[0], h[n - 1]) ? 0 : -1;
+    if (orientation(h[0], h[1], p) < 0 || orientation(h[0], h[n - 1], p) > 0)
+        return -1;
+    // Last i with p not clockwise from h[0] -> h[i].
+    int lo = 1, hi = n - 1;
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (orientation(h[0], h[mid], p) >= 0)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    int o = orientation(h[lo], h[lo + 1], p);
+    if (o < 0)
+        return -1;
+    if (o == 0 || (lo == 1 && on(h[0], h[1])) || (lo + 1 == n - 1 && on(h[0], h[n - 1])))
+        return 0;
+    return 1;
+}
+
+// Batch version for many queries, spread over threads.
+template<typename T>
+vector<int> PointInConvexPolygon(const vector<Point<T>>& h, const PointBatch<T>& queries, int threads=1) {
+    vector<int> res(queries.size());
+    parallelRanges(queries.size(), threads, [&](int from, int to) {
+        for (int i = from; i < to; ++i) {
+            res[i] = PointInConvexPolygon(h, queries[i]);
+        }
+    });
+    return res;
+}
+
+// Static k-d tree with an implicit layout: every subtree occupies a contiguous
+// range of pts with its splitting point in the middle, levels alternate
+// between splitting by x and by y. Queries return indices into the vector
+// the tree was built from. Radii are passed squared, so queries on integer
+// points are exact.
+template<typename T>
+class KdTree {
+public:
+    KdTree(const vector<Point<T>>& v) : pts(v.size()), ids(v.size()) {
+        vector<pair<Point<T>, int>> items(v.size());
+        for (int i = 0; i < v.size(); ++i) {
+            items[i] = {v[i], i};
+        }
+        build(items, 0, v.size(), 0);
+        for (int i = 0; i < v.size(); ++i) {
+            tie(pts[i], ids[i]) = items[i];
+        }
+    }
+
+    // The k points closest to p, nearest first.
+    vector<int> knn(const Point<T>& p, int k) const {
+        Heap heap;
+        if (k > 0)
+            knn(p, k, 0, pts.size(), 0, heap);
+        vector<int> res(heap.size());
+        for (int i = res.size() - 1; i >= 0; --i, heap.pop()) {
+            res[i] = ids[heap.top().second];
+        }
+        return res;
+    }
+
+    // Points at squared distance at most r2 from p.
+    vector<int> radius(const Point<T>& p, const Wide<T>& r2) const {
+        vector<int> res;
+        radius(p, r2, 0, pts.size(), 0, res);
+        return res;
+    }
+
+    // Points with lo.x <= x <= hi.x and lo.y <= y <= hi.y.
+    vector<int> rect(const Point<T>& lo, const Point<T>& hi) const {
+        vector<int> res;
+        rect(lo, hi, 0, pts.size(), 0, res);
+        return res;
+    }
+
+    // Batch versions, spread over threads.
+    vector<vector<int>> knn(const vector<Point<T>>& queries, int k, int threads=1) const {
+        return batch(queries.size(), threads, [&](int i) { return knn(queries[i], k); });
+    }
+
+    vector<vector<int>> radius(const vector<Point<T>>& queries, const Wide<T>& r2, int threads=1) const {
+        return batch(queries.size(), threads, [&](int i) { return radius(queries[i], r2); });
+    }
+
+    vector<vector<int>> rect(const vector<pair<Point<T>, Point<T>>>& queries, int threads=1) const {
+        return batch(queries.size(), threads, [&](int i) { return rect(queries[i].first, queries[i].second); });
+    }
+
+private:
+    typedef priority_queue<pair<Wide<T>, int>> Heap;
+
+    vector<Point<T>> pts;
+    vector<int> ids;
+
+    static const T& coord(const Point<T>& p, int axis) {
+        return axis ? p.y : p.x;
+    }
+
+    static void build(vector<pair<Point<T>, int>>& items, int l, int r, int axis) {
+        if (r - l <= 1)
+            return;
+        int m = (l + r) / 2;
+        nth_element(items.begin() + l, items.begin() + m, items.begin() + r,
+            [&](const pair<Point<T>, int>& a, const pair<Point<T>, int>& b) {
+                return coord(a.first, axis) < coord(b.first, axis);
+            });
+        build(items, l, m, axis ^ 1);
+        build(items, m + 1, r, axis ^ 1);
+    }
+
+    void knn(const Point<T>& p, int k, int l, int r, int axis, Heap& heap) const {
+        if (l >= r)
+            return;
+        int m = (l + r) / 2;
+        Wide<T> d = sqrdist(p, pts[m]);
+        if (heap.size() < k || d < heap.top().first) {
+            heap.push({d, m});
+            if (heap.size() > k)
+                heap.pop();
+        }
+        Wide<T> diff = Wide<T>(coord(p, axis)) - coord(pts[m], axis);
+        if (diff < 0) {
+            knn(p, k, l, m, axis ^ 1, heap);
+            if (heap.size() < k || diff * diff < heap.top().first)
+                knn(p, k, m + 1, r, axis ^ 1, heap);
+        } else {
+            knn(p, k, m + 1, r, axis ^ 1, heap);
+            if (heap.size() < k || diff * diff < heap.top().first)
+                knn(p, k, l, m, axis ^ 1, heap);
+        }
+    }
+
+    void radius(const Point<T>& p, const Wide<T>& r2, int l, int r, int axis, vector<int>& res) const {
+        if (l >= r)
+            return;
+        int m = (l + r) / 2;
+        if (sqrdist(p, pts[m]) <= r2)
+            res.push_back(ids[m]);
+        Wide<T> diff = Wide<T>(coord(p, axis)) - coord(pts[m], axis);
+        if (diff <= 0 || diff * diff <= r2)
+            radius(p, r2, l, m, axis ^ 1, res);
+        if (diff >= 0 || diff * diff <= r2)
+            radius(p, r2, m + 1, r, axis ^ 1, res);
+    }
+
+    void rect(const Point<T>& lo, const Point<T>& hi, int l, int r, int axis, vector<int>& res) const {
+        if (l >= r)
+            return;
+        int m = (l + r) / 2;
+        const Point<T>& q = pts[m];
+        if (lo.x <= q.x && q.x <= hi.x && lo.y <= q.y && q.y <= hi.y)
+            res.push_back(ids[m]);
+        if (coord(lo, axis) <= coord(q, axis))
+            rect(lo, hi, l, m, axis ^ 1, res);
+        if (coord(q, axis) <= coord(hi, axis))
+            rect(lo, hi, m + 1, r, axis ^ 1, res);
+    }
+
+    template<typename F>
+    static vector<vector<int>> batch(int n, int threads, const F& f) {
+        vector<vector<int>> res(n);
+        parallelRanges(n, threads, [&](int from, int to) {
+            for (int i = from; i < to; ++i) {
+                res[i] = f(i);
+            }
+        });
+        return res;
+    }
+};
+
+// Bucketed uniform grid. Points are sorted by cell into one array with cell
+// offsets in start, so a cell is a contiguous range. The default cell size
+// gives about two points per cell. Better than KdTree for evenly spread
+// points and small radii; same query interface and results.
+template<typename T>
+class UniformGrid {
+public:
+    UniformGrid(const vector<Point<T>>& v, double cellSize=0) : pts(v.size()), ids(v.size()) {
+        int n = v.size();
+        double maxx = 0, maxy = 0;
+        minx = miny = 0;
+        for (int i = 0; i < n; ++i) {
+            double x = v[i].x, y = v[i].y;
+            if (i == 0 || x < minx) minx = x;
+            if (i == 0 || y < miny) miny = y;
+            if (i == 0 || x > maxx) maxx = x;
+            if (i == 0 || y > maxy) maxy = y;
+        }
+        double spanx = maxx - minx, spany = maxy - miny;
+        cell = cellSize;
+        if (cell <= 0) {
+            cell = spanx * spany > 0 ? sqrt(2 * spanx * spany / n) : 2 * max(spanx, spany) / max(n, 1);
+            if (cell <= 0)
+                cell = 1;
+        }
+        while (true) {
+            double cx = floor(spanx / cell) + 1, cy = floor(spany / cell) + 1;
+            if (cx * cy <= 4.0 * n + 16) {
+                nx = cx;
+                ny = cy;
+                break;
+            }
+            cell *= 2;
+        }
+
+        vector<int> cellOf(n);
+        start.assign(nx * ny + 1, 0);
+        for (int i = 0; i < n; ++i) {
+            cellOf[i] = cellY(v[i].y) * nx + cellX(v[i].x);
+            ++start[cellOf[i] + 1];
+        }
+        partial_sum(start.begin(), start.end(), start.begin());
+        vector<int> pos(start.begin(), start.end() - 1);
+        for (int i = 0; i < n; ++i) {
+            int j = pos[cellOf[i]]++;
+            pts[j] = v[i];
+            ids[j] = i;
+        }
+    }
+
+    // The k points closest to p, nearest first. Searches rings of cells
+    // around p until no unvisited cell can hold anything closer.
+    vector<int> knn(const Point<T>& p, int k) const {
+        priority_queue<pair<Wide<T>, int>> heap;
+        int cx = cellX(p.x), cy = cellY(p.y);
+        for (int d = 0; k > 0 && d <= max(nx, ny); ++d) {
+            auto visit = [&](int x, int y) {
+                if (x < 0 || x >= nx || y < 0 || y >= ny)
+                    return;
+                for (int j = start[y * nx + x]; j < start[y * nx + x + 1]; ++j) {
+                    Wide<T> dist = sqrdist(p, pts[j]);
+                    if (heap.size() < k || dist < heap.top().first) {
+                        heap.push({dist, j});
+                        if (heap.size() > k)
+                            heap.pop();
+                    }
+                }
+            };
+            for (int x = cx - d; x <= cx + d; ++x) {
+                visit(x, cy - d);
+                if (d > 0)
+                    visit(x, cy + d);
+            }
+            for (int y = cy - d + 1; y <= cy + d - 1; ++y) {
+                visit(cx - d, y);
+                visit(cx + d, y);
+            }
+            if (heap.size() == k) {
+                // Distance from p to the cells outside the visited block.
+                double px = p.x, py = p.y, bound = numeric_limits<double>::infinity();
+                if (cx - d > 0) bound = min(bound, px - (minx + (cx - d) * cell));
+                if (cx + d < nx - 1) bound = min(bound, minx + (cx + d + 1) * cell - px);
+                if (cy - d > 0) bound = min(bound, py - (miny + (cy - d) * cell));
+                if (cy + d < ny - 1) bound = min(bound, miny + (cy + d + 1) * cell - py);
+                bound = max(bound, 0.0);
+                if ((double)heap.top().first < bound * bound * (1 - 1e-9))
+                    break;
+            }
+        }
+        vector<int> res(heap.size());
+        for (int i = res.size() - 1; i >= 0; --i, heap.pop()) {
+            res[i] = ids[heap.top().second];
+        }
+        return res;
+    }
+
+    // Points at squared distance at most r2 from p.
+    vector<int> radius(const Point<T>& p, const Wide<T>& r2) const {
+        vector<int> res;
+        double px = p.x, py = p.y;
+        // Slack for the rounding of the box around the circle.
+        double r = sqrt((double)r2);
+        r += 1e-9 * (r + fabs(px) + fabs(py));
+        for (int y = cellY(py - r); y <= cellY(py + r); ++y) {
+            for (int x = cellX(px - r); x <= cellX(px + r); ++x) {
+                for (int j = start[y * nx + x]; j < start[y * nx + x + 1]; ++j) {
+                    if (sqrdist(p, pts[j]) <= r2)
+                        res.push_back(ids[j]);
+                }
+            }
+        }
+        return res;
+    }
+
+    // Points with lo.x <= x <= hi.x and lo.y <= y <= hi.y.
+    vector<int> rect(const Point<T>& lo, const Point<T>& hi) const {
+        vector<int> res;
+        if (hi.x < lo.x || hi.y < lo.y)
+            return res;
+        for (int y = cellY(lo.y); y <= cellY(hi.y); ++y) {
+            for (int x = cellX(lo.x); x <= cellX(hi.x); ++x) {
+                for (int j = start[y * nx + x]; j < start[y * nx + x + 1]; ++j) {
+                    const Point<T>& q = pts[j];
+                    if (lo.x <= q.x && q.x <= hi.x && lo.y <= q.y && q.y <= hi.y)
+                        res.push_back(ids[j]);
+                }
+            }
+        }
+        return res;
+    }
+
+    // Batch versions, spread over threads.
+    vector<vector<int>> knn(const vector<Point<T>>& queries, int k, int threads=1) const {
+        return batch(queries.size(), threads, [&](int i) { return knn(queries[i], k); });
+    }
+
+    vector<vector<int>> radius(const vector<Point<T>>& queries, const Wide<T>& r2, int threads=1) const {
+        return batch(queries.size(), threads, [&](int i) { return radius(queries[i], r2); });
+    }
+
+    vector<vector<int>> rect(const vector<pair<Point<T>, Point<T>>>& queries, int threads=1) const {
+        return batch(queries.size(), threads, [&](int i) { return rect(queries[i].first, queries[i].second); });
+    }
+
+private:
+    vector<Point<T>> pts;
+    vector<int> ids, start;
+    double minx, miny, cell;
+    int nx, ny;
+
+    // Monotone in the coordinate, clamped to the grid.
+    int cellX(double x) const {
+        double c = floor((x - minx) / cell);
+        return c < 0 ? 0 : c >= nx ? nx - 1 : (int)c;
+    }
+
+    int cellY(double y) const {
+        double c = floor((y - miny) / cell);
+        return c < 0 ? 0 : c >= ny ? ny - 1 : (int)c;
+    }
+
+    template<typename F>
+    static vector<vector<int>> batch(int n, int threads, const F& f) {
+        vector<vector<int>> res(n);
+        parallelRanges(n, threads, [&](int from, int to) {
+            for (int i = from; i < to; ++i) {
+                res[i] = f(i);
+            }
+        });
+        return res;
+    }
+};
+
+// Indices of a closest pair of points, O(n log n) by divide and conquer
+// with merging by y. Needs at least two points; exact for integer points.
+template<typename T>
+pair<int, int> ClosestPair(const vector<Point<T>>& v) {
+    typedef pair<Point<T>, int> Item;
+    int n = v.size();
+    assert(n >= 2);
+    vector<Item> a(n), buf(n);
+    for (int i = 0; i < n; ++i) {
+        a[i] = {v[i], i};
+    }
+    sort(a.begin(), a.end(), [](const Item& p, const Item& q) {
+        return tie(p.first.x, p.first.y) < tie(q.first.x, q.first.y);
+    });
+    auto byY = [](const Item& p, const Item& q) {
+        return p.first.y < q.first.y;
+    };
+
+    pair<int, int> best = {a[0].second, a[1].second};
+    Wide<T> bestDist = sqrdist(a[0].first, a[1].first);
+    auto consider = [&](const Item& p, const Item& q) {
+        Wide<T> d = sqrdist(p.first, q.first);
+        if (d < bestDist) {
+            bestDist = d;
+            best = {p.second, q.second};
+        }
+    };
+
+    // Sorts a[l, r) by y on the way out.
+    auto rec = [&](auto&& self, int l, int r) -> void {
+        if (r - l <= 3) {
+            for (int i = l; i < r; ++i) {
+                for (int j = i + 1; j < r; ++j) {
+                    consider(a[i], a[j]);
+                }
+            }
+            sort(a.begin() + l, a.begin() + r, byY);
+            return;
+        }
+        int m = (l + r) / 2;
+        T midx = a[m].first.x;
+        self(self, l, m);
+        self(self, m, r);
+        merge(a.begin() + l, a.begin() + m, a.begin() + m, a.begin() + r, buf.begin(), byY);
+        copy(buf.begin(), buf.begin() + (r - l), a.begin() + l);
+
+        int strip = 0;
+        for (int i = l; i < r; ++i) {
+            Wide<T> dx = Wide<T>(a[i].first.x) - midx;
+            if (dx * dx >= bestDist)
+                continue;
+            for (int j = strip - 1; j >= 0; --j) {
+                Wide<T> dy = Wide<T>(a[i].first.y) - buf[j].first.y;
+                if (dy * dy >= bestDist)
+                    break;
+                consider(a[i], buf[j]);
+            }
+            buf[strip++] = a[i];
+        }
+    };
+    rec(rec, 0, n);
+    return best;
+}
+
+// Planar subdivision as half-edges. Half-edge e goes from origin[e] to
+// origin[twin[e]] and next[e] follows it around the face on its left, so
+// bounded faces are traced counterclockwise. outer is a half-edge of the
+// unbounded face, -1 if there is none.
+struct HalfEdgeMesh {
+    int vertices = 0;
+    int outer = -1;
+    vector<int> origin, twin, next;
+
+    int size() const {
+        return origin.size();
+    }
+};
+
+// Delaunay triangulation by the Guibas-Stolfi divide and conquer on
+// quad-edges, O(n log n), with the exact orientation and incircle tests.
+// Vertices of the mesh are indices into v; of equal points only the first
+// is used. Colinear input gives a path. The dual of the result, from
+// buildDual in planar_dual_graph.cpp, is the Voronoi diagram with vertices
+// at the triangle circumcenters. An object only holds scratch space, which
+// later calls reuse; v is not kept.
+template<typename T>
+class Delaunay {
+public:
+    HalfEdgeMesh triangulate(const vector<Point<T>>& v) {
+        int n = v.size();
+        ids.resize(n);
+        iota(ids.begin(), ids.end(), 0);
+        sort(ids.begin(), ids.end(), [&](int i, int j) {
+            return tie(v[i].x, v[i].y, i) < tie(v[j].x, v[j].y, j);
+        });
+        ids.erase(unique(ids.begin(), ids.end(), [&](int i, int j) {
+            return tie(v[i].x, v[i].y) == tie(v[j].x, v[j].y);
+        }), ids.end());
+        // Work on the sorted points, so the recursion touches nearby memory.
+        pts.resize(ids.size());
+        for (int i = 0; i < ids.size(); ++i) {
+            pts[i] = v[ids[i]];
+        }
+
+        onext.clear();
+        org.clear();
+        dead.clear();
+        freeList.clear();
+        int outer = -1;
+        if (pts.size() >= 2)
+            outer = sym(build(0, pts.size()).first);
+        return toMesh(n, outer);
+    }
+
+private:
+    // Quarter-edges 4k..4k+3 belong to edge k, rotating by 90 degrees each;
+    // 4k and 4k+2 are the primal half-edges. Vertices are indices into pts,
+    // ids maps them back to the input.
+    vector<Point<T>> pts;
+    vector<int> ids, onext, org, freeList;
+    vector<bool> dead;
+
+    static int rot(int e) { return (e & ~3) | ((e + 1) & 3); }
+    static int invrot(int e) { return (e & ~3) | ((e + 3) & 3); }
+    static int sym(int e) { return e ^ 2; }
+    int lnext(int e) const { return rot(onext[invrot(e)]); }
+    int oprev(int e) const { return rot(onext[rot(e)]); }
+    int dest(int e) const { return org[sym(e)]; }
+
+    int makeEdge(int a, int b) {
+        int k;
+        if (!freeList.empty()) {
+            k = freeList.back();
+            freeList.pop_back();
+            dead[k] = false;
+        } else {
+            k = dead.size();
+            dead.push_back(false);
+            onext.resize(4 * k + 4);
+            org.resize(4 * k + 4);
+        }
+        int e = 4 * k;
+        onext[e] = e;
+        onext[e + 2] = e + 2;
+        onext[e + 1] = e + 3;
+        onext[e + 3] = e + 1;
+        org[e] = a;
+        org[e + 2] = b;
+        return e;
+    }
+
+    void splice(int a, int b) {
+        int alpha = rot(onext[a]), beta = rot(onext[b]);
+        swap(onext[a], onext[b]);
+        swap(onext[alpha], onext[beta]);
+    }
+
+    void deleteEdge(int e) {
+        splice(e, oprev(e));
+        splice(sym(e), oprev(sym(e)));
+        dead[e >> 2] = true;
+        freeList.push_back(e >> 2);
+    }
+
+    int connect(int a, int b) {
+        int e = makeEdge(dest(a), org[b]);
+        splice(e, lnext(a));
+        splice(sym(e), b);
+        return e;
+    }
+
+    int ccw(int a, int b, int c) const {
+        return orientation(pts[a], pts[b], pts[c]);
+    }
+
+    bool leftOf(int p, int e) const {
+        return ccw(p, org[e], dest(e)) > 0;
+    }
+
+    bool rightOf(int p, int e) const {
+        return ccw(p, org[e], dest(e)) < 0;
+    }
+
+    bool inCircle(int a, int b, int c, int d) const {
+        return incircle(pts[a], pts[b], pts[c], pts[d]) > 0;
+    }
+
+    // Triangulates pts[l, r). Returns the counterclockwise convex hull
+    // edge out of the leftmost vertex and the clockwise one out of the
+    // rightmost vertex.
+    pair<int, int> build(int l, int r) {
+        if (r - l == 2) {
+            int e = makeEdge(l, l + 1);
+            return {e, sym(e)};
+        }
+        if (r - l == 3) {
+            int a = makeEdge(l, l + 1);
+            int b = makeEdge(l + 1, l + 2);
+            splice(sym(a), b);
+            int o = ccw(l, l + 1, l + 2);
+            if (o == 0)
+                return {a, sym(b)};
+            int c = connect(b, a);
+            if (o > 0)
+                return {a, sym(b)};
+            return {sym(c), c};
+        }
+        int m = (l + r) / 2;
+        int ldo, ldi, rdi, rdo;
+        tie(ldo, ldi) = build(l, m);
+        tie(rdi, rdo) = build(m, r);
+
+        // Lower common tangent of the two halves.
+        while (true) {
+            if (leftOf(org[rdi], ldi)) {
+                ldi = lnext(ldi);
+            } else if (rightOf(org[ldi], rdi)) {
+                rdi = onext[sym(rdi)];
+            } else {
+                break;
+            }
+        }
+        int basel = connect(sym(rdi), ldi);
+        if (org[ldi] == org[ldo])
+            ldo = sym(basel);
+        if (org[rdi] == org[rdo])
+            rdo = basel;
+
+        // Zip the halves together from the bottom up.
+        auto valid = [&](int e) {
+            return rightOf(dest(e), basel);
+        };
+        while (true) {
+            int lcand = onext[sym(basel)];
+            if (valid(lcand)) {
+                while (inCircle(dest(basel), org[basel], dest(lcand), dest(onext[lcand]))) {
+                    int t = onext[lcand];
+                    deleteEdge(lcand);
+                    lcand = t;
+                }
+            }
+            int rcand = oprev(basel);
+            if (valid(rcand)) {
+                while (inCircle(dest(basel), org[basel], dest(rcand), dest(oprev(rcand)))) {
+                    int t = oprev(rcand);
+                    deleteEdge(rcand);
+                    rcand = t;
+                }
+            }
+            if (!valid(lcand) && !valid(rcand))
+                break;
+            if (!valid(lcand) || (valid(rcand) && inCircle(dest(lcand), org[lcand], org[rcand], dest(rcand))))
+                basel = connect(rcand, sym(basel));
+            else
+                basel = connect(sym(basel), sym(lcand));
+        }
+        return {ldo, rdo};
+    }
+
+    HalfEdgeMesh toMesh(int vertices, int outer) const {
+        vector<int> id(onext.size(), -1);
+        int m = 0;
+        for (int k = 0; k < dead.size(); ++k) {
+            if (!dead[k]) {
+                id[4 * k] = m++;
+                id[4 * k + 2] = m++;
+            }
+        }
+        HalfEdgeMesh mesh;
+        mesh.vertices = vertices;
+        mesh.outer = outer == -1 ? -1 : id[outer];
+        mesh.origin.resize(m);
+        mesh.twin.resize(m);
+        mesh.next.resize(m);
+        for (int e = 0; e < onext.size(); e += 2) {
+            if (id[e] != -1) {
+                mesh.origin[id[e]] = ids[org[e]];
+                mesh.twin[id[e]] = id[sym(e)];
+                mesh.next[id[e]] = id[lnext(e)];
+            }
+        }
+        return mesh;
+    }
+};
+
+// Center of the circle through a, b and c, which must not be colinear.
+template<typename T>
+Point<Real<T>> Circumcenter(const Point<T>& a, const Point<T>& b, const Point<T>& c) {
+    typedef Real<T> R;
+    Point<R> ab(R(b.x) - a.x, R(b.y) - a.y), ac(R(c.x) - a.x, R(c.y) - a.y);
+    R d = 2 * cross(ab, ac);
+    R bl = ab.sqrlen(), cl = ac.sqrlen();
+    return Point<R>(a.x + (ac.y * bl - ab.y * cl) / d, a.y + (ab.x * cl - ac.x * bl) / d);
+}
+
 int main() {
-    auto tup = LineEquation(Point(1, 0), Point(0, 1));
+    auto tup = LineEquation(Point<double>(1, 0), Point<double>(0, 1));
     double a, b, c;
     tie(a, b, c) = tup;
     cout << a << " " << b << " " << c << "\n";
-}
\ No newline at end of file
+
+    // The unit square cut by a 45 degree line, all given by short and
+    // nearly parallel direction vectors.
+    typedef Point<double> P;
+    double e = 1e-7;
+    vector<pair<P, P>> h = {{P(0, 0), P(e, 0)}, {P(1, 0), P(1, e)},
+        {P(1, 1), P(1 - e, 1)}, {P(0, 1), P(0, 1 - e)},
+        {P(0.5, 0), P(0.5 + e, e)}, {P(0, 0.9), P(1, 0.9 + 1e-12)}};
+    for (const P& p : HalfPlaneIntersection(h)) {
+        cout << p.x << " " << p.y << "\n";
+    }
+}
@@ -1,78 +1,847 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
 
 using namespace std;
 
 typedef long long int64;
+typedef unsigned long long uint64;
+typedef unsigned __int128 uint128;
 
+// Number theoretic transform modulo three primes, recombined with Garner's
+// algorithm like MultiModConvolution in fft.cpp. The primes multiply to
+// more than 2^92, so convolutions of values below 2^32 are exact for
+// operands of up to 2^24 elements.
+namespace ntt {
+
+template<uint32_t M>
+uint64_t Power(uint64_t x, uint64_t pw) {
+    uint64_t r = 1;
+    for (x %= M; pw; pw >>= 1, x = x * x % M) {
+        if (pw & 1) {
+            r = r * x % M;
+        }
+    }
+    return r;
+}
+
+template<uint32_t M, uint32_t G>
+void Transform(vector<uint32_t>& a, bool invert) {
+    int n = a.size();
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            swap(a[i], a[j]);
+        }
+    }
+    vector<uint32_t> w(max(1, n / 2));
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len / 2;
+        uint64_t root = Power<M>(G, (M - 1) / len);
+        if (invert) {
+            root = Power<M>(root, M - 2);
+        }
+        w[0] = 1;
+        for (int i = 1; i < half; ++i) {
+            w[i] = w[i-1] * root % M;
+        }
+        for (int i = 0; i < n; i += len) {
+            for (int j = 0; j < half; ++j) {
+                uint32_t x = a[i+j];
+                uint32_t y = (uint64_t)a[i+j+half] * w[j] % M;
+                a[i+j] = x + y >= M ? x + y - M : x + y;
+                a[i+j+half] = x >= y ? x - y : x + M - y;
+            }
+        }
+    }
+    if (invert) {
+        uint64_t inv = Power<M>(n, M - 2);
+        for (auto& x : a) {
+            x = x * inv % M;
+        }
+    }
+}
+
+template<uint32_t M, uint32_t G>
+vector<uint32_t> Convolve(const vector<uint32_t>& a, const vector<uint32_t>& b, int n) {
+    vector<uint32_t> fa(n), fb(n);
+    for (size_t i = 0; i < a.size(); ++i) {
+        fa[i] = a[i] % M;
+    }
+    for (size_t i = 0; i < b.size(); ++i) {
+        fb[i] = b[i] % M;
+    }
+    Transform<M, G>(fa, false);
+    Transform<M, G>(fb, false);
+    for (int i = 0; i < n; ++i) {
+        fa[i] = (uint64_t)fa[i] * fb[i] % M;
+    }
+    Transform<M, G>(fa, true);
+    fa.resize(a.size() + b.size() - 1);
+    return fa;
+}
+
+// The exact convolution of a and b.
+vector<uint128> Convolve(const vector<uint32_t>& a, const vector<uint32_t>& b) {
+    const uint32_t p1 = 2013265921, p2 = 1811939329, p3 = 2113929217;
+    int n = 1;
+    while (n < (int)(a.size() + b.size())) {
+        n <<= 1;
+    }
+    auto r1 = Convolve<p1, 31>(a, b, n);
+    auto r2 = Convolve<p2, 13>(a, b, n);
+    auto r3 = Convolve<p3, 5>(a, b, n);
+    const uint64_t inv1 = Power<p2>(p1, p2 - 2);
+    const uint64_t inv12 = Power<p3>((uint64_t)p1 * p2 % p3, p3 - 2);
+    vector<uint128> result(r1.size());
+    for (size_t i = 0; i < r1.size(); ++i) {
+        uint64_t k1 = (r2[i] + p2 - r1[i] % p2) * inv1 % p2;
+        uint64_t low = r1[i] + (uint64_t)p1 * k1;
+        uint64_t k2 = (r3[i] + p3 - low % p3) * inv12 % p3;
+        result[i] = low + (uint128)((uint64_t)p1 * p2) * k2;
+    }
+    return result;
+}
+
+}  // namespace ntt
+
+// Limb storage with room for two limbs inline, so arithmetic on values
+// below 2^128 never allocates; the kernels only grow a value by a limb it
+// really needs. Longer values move to the heap and stay there.
+class Limbs {
+  public:
+    static const int kInline = 2;
+
+  private:
+    size_t n = 0;
+    bool big = false;
+    uint64 local[kInline];
+    vector<uint64> heap;
+
+  public:
+    Limbs() {}
+
+    explicit Limbs(size_t count) {
+        resize(count);
+    }
+
+    Limbs(const uint64* first, const uint64* last) {
+        assign(first, last);
+    }
+
+    Limbs(const Limbs& other) {
+        assign(other.begin(), other.end());
+    }
+
+    Limbs(Limbs&& other) noexcept {
+        *this = move(other);
+    }
+
+    Limbs& operator = (const Limbs& other) {
+        if (this != &other) {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    Limbs& operator = (Limbs&& other) noexcept {
+        if (this == &other) {
+            return *this;
+        }
+        if (other.big) {
+            heap = move(other.heap);
+            big = true;
+            n = other.n;
+        } else {
+            assign(other.begin(), other.end());
+        }
+        other.heap.clear();
+        other.big = false;
+        other.n = 0;
+        return *this;
+    }
+
+    void assign(const uint64* first, const uint64* last) {
+        size_t m = last - first;
+        if (big || m > kInline) {
+            heap.assign(first, last);
+            big = true;
+        } else {
+            copy(first, last, local);
+        }
+        n = m;
+    }
+
+    // New limbs are zero.
+    void resize(size_t m) {
+        if (!big && m > kInline) {
+            heap.assign(local, local + n);
+            big = true;
+        }
+        if (big) {
+            heap.resize(m);
+        } else if (m > n) {
+            fill(local + n, local + m, 0);
+        }
+        n = m;
+    }
+
+    void push_back(uint64 x) {
+        resize(n + 1);
+        data()[n-1] = x;
+    }
+
+    void pop_back() {
+        resize(n - 1);
+    }
+
+    void clear() {
+        resize(0);
+    }
+
+    size_t size() const {
+        return n;
+    }
+
+    bool empty() const {
+        return n == 0;
+    }
+
+    uint64* data() {
+        return big ? heap.data() : local;
+    }
+
+    const uint64* data() const {
+        return big ? heap.data() : local;
+    }
+
+    uint64* begin() {
+        return data();
+    }
+
+    uint64* end() {
+        return data() + n;
+    }
+
+    const uint64* begin() const {
+        return data();
+    }
+
+    const uint64* end() const {
+        return data() + n;
+    }
+
+    uint64& operator [] (size_t i) {
+        return data()[i];
+    }
+
+    uint64 operator [] (size_t i) const {
+        return data()[i];
+    }
+
+    uint64& back() {
+        return data()[n-1];
+    }
+
+    bool operator == (const Limbs& other) const {
+        return n == other.n && equal(begin(), end(), other.begin());
+    }
+};
+
+// Signed integers stored as a sign and the little endian limbs of the
+// magnitude in base 2^64. Zero is never negative.
 class Huge {
-    static const int kLogBase = 9;
-    static int pw10(int x) {
-        int r = 1;
-        for (int i = 0; i < x; ++i) {
-            r *= 10;
+    // Multiplication switches from schoolbook to Karatsuba and from
+    // Karatsuba to NTT at these operand sizes, in limbs.
+    static const int kKaratsubaLimbs = 32;
+    static const int kNttLimbs = 2048;
+    // Division uses a Newton reciprocal once both the divisor and the
+    // quotient have this many limbs.
+    static const int kNewtonLimbs = 64;
+    // Decimal conversion works on chunks of kChunkDigits digits and
+    // switches to quadratic conversion below 2^kDecimalLevel chunks. Halves
+    // of numbers with kParallelLimbs limbs go to separate threads. Any
+    // number of conversions may run at once from different threads, as
+    // the powers of ten they share are cached under a lock.
+    static const int kChunkDigits = 18;
+    static const int64 kChunk = 1000000000000000000LL;
+    static const int kDecimalLevel = 4;
+    static const int kParallelLimbs = 2048;
+    // Cached levels of powers of ten; 10^(kChunkDigits * 2^48) would not
+    // fit in memory.
+    static const int kDecimalLevels = 48;
+    Limbs v;
+    bool negative = false;
+
+    static void Trim(Limbs& a) {
+        while (!a.empty() && a.back() == 0) {
+            a.pop_back();
+        }
+    }
+
+    // a += b * 2^(64 * shift).
+    static void AddShifted(Limbs& a, const Limbs& b, int shift) {
+        if (a.size() < b.size() + shift) {
+            a.resize(b.size() + shift);
+        }
+        uint64 carry = 0;
+        for (size_t i = 0; i < b.size() || carry; ++i) {
+            if (shift + i == a.size()) {
+                a.push_back(0);
+            }
+            uint128 s = (uint128)a[shift+i] + (i < b.size() ? b[i] : 0) + carry;
+            a[shift+i] = (uint64)s;
+            carry = s >> 64;
+        }
+    }
+
+    // a -= b and returns the final borrow, which is set if a < b.
+    static bool Subtract(Limbs& a, const Limbs& b) {
+        uint64 borrow = 0;
+        size_t i = 0;
+        for (; i < b.size() || (i < a.size() && borrow); ++i) {
+            uint128 d = (uint128)a[i] - (i < b.size() ? b[i] : 0) - borrow;
+            a[i] = (uint64)d;
+            borrow = (uint64)(d >> 64) != 0;
+        }
+        Trim(a);
+        return borrow;
+    }
+
+    // a *= b.
+    static void MultiplySmall(Limbs& a, uint64 b) {
+        uint64 carry = 0;
+        for (size_t i = 0; i < a.size(); ++i) {
+            uint128 t = (uint128)a[i] * b + carry;
+            a[i] = (uint64)t;
+            carry = t >> 64;
+        }
+        if (carry) {
+            a.push_back(carry);
+        }
+        Trim(a);
+    }
+
+    // a += b * m.
+    static void AddMul(Limbs& a, const Limbs& b, uint64 m) {
+        if (a.size() < b.size()) {
+            a.resize(b.size());
+        }
+        uint64 carry = 0;
+        size_t i = 0;
+        for (; i < b.size(); ++i) {
+            uint128 t = (uint128)b[i] * m + a[i] + carry;
+            a[i] = (uint64)t;
+            carry = t >> 64;
+        }
+        for (; carry; ++i) {
+            if (i == a.size()) {
+                a.push_back(0);
+            }
+            uint128 t = (uint128)a[i] + carry;
+            a[i] = (uint64)t;
+            carry = t >> 64;
+        }
+        Trim(a);
+    }
+
+    // a -= b * m. If that underflows, a becomes the magnitude of the
+    // result and the return value is true. The final borrow stays in a
+    // local, so a only grows when the magnitude needs the extra limb.
+    static bool SubMul(Limbs& a, const Limbs& b, uint64 m) {
+        if (a.size() < b.size()) {
+            a.resize(b.size());
+        }
+        uint64 borrow = 0;
+        size_t i = 0;
+        for (; i < b.size(); ++i) {
+            uint128 t = (uint128)b[i] * m + borrow;
+            uint64 low = (uint64)t;
+            borrow = (uint64)(t >> 64) + (a[i] < low);
+            a[i] -= low;
+        }
+        for (; borrow && i < a.size(); ++i) {
+            uint64 low = borrow;
+            borrow = a[i] < low;
+            a[i] -= low;
+        }
+        if (borrow) {
+            // a now holds the result plus borrow * 2^(64 * size).
+            bool rest = any_of(a.begin(), a.end(), [](uint64 x) { return x != 0; });
+            Negate(a);
+            if (borrow - rest) {
+                a.push_back(borrow - rest);
+            }
+        }
+        Trim(a);
+        return borrow;
+    }
+
+    // Replaces a by 2^(64 * size) - a.
+    static void Negate(Limbs& a) {
+        uint64 carry = 1;
+        for (size_t i = 0; i < a.size(); ++i) {
+            a[i] = ~a[i] + carry;
+            carry = carry && a[i] == 0;
+        }
+    }
+
+    static int CompareMagnitude(const Limbs& a, const Limbs& b) {
+        if (a.size() != b.size()) {
+            return a.size() < b.size() ? -1 : 1;
+        }
+        for (int i = (int)a.size() - 1; i >= 0; --i) {
+            if (a[i] != b[i]) {
+                return a[i] < b[i] ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    // *this += sign * b * m, where sign is -1 if subtract is set.
+    void MulAccumulate(const Limbs& b, uint64 m, bool subtract) {
+        if (subtract == negative) {
+            AddMul(v, b, m);
+        } else if (SubMul(v, b, m)) {
+            negative = !negative;
+        }
+        Normalize();
+    }
+
+    void Normalize() {
+        Trim();
+        if (v.empty()) {
+            negative = false;
+        }
+    }
+
+    static Limbs MultiplySchool(const Limbs& a, const Limbs& b) {
+        if (a.empty() || b.empty()) {
+            return {};
+        }
+        int n = a.size(), m = b.size();
+        // Short products are formed on the stack, so those that fit
+        // inline after trimming never allocate.
+        uint64 small[Limbs::kInline + 1] = {};
+        Limbs result;
+        uint64* r = small;
+        if (n + m > Limbs::kInline + 1) {
+            result.resize(n + m);
+            r = result.data();
+        }
+        for (int i = 0; i < n; ++i) {
+            uint64 carry = 0;
+            for (int j = 0; j < m; ++j) {
+                uint128 t = (uint128)a[i] * b[j] + r[i+j] + carry;
+                r[i+j] = (uint64)t;
+                carry = t >> 64;
+            }
+            r[i+m] = carry;
+        }
+        if (r == small) {
+            int len = n + m;
+            while (len > 0 && small[len-1] == 0) {
+                --len;
+            }
+            return Limbs(small, small + len);
+        }
+        Trim(result);
+        return result;
+    }
+
+    static Limbs MultiplyKaratsuba(const Limbs& a, const Limbs& b) {
+        int n = a.size(), m = b.size();
+        if (n < m) {
+            return MultiplyKaratsuba(b, a);
+        }
+        if (m < kKaratsubaLimbs) {
+            return MultiplySchool(a, b);
         }
-        return r;
+        if (n >= 2 * m) {
+            // Unbalanced: multiply b by slices of a of its own length.
+            Limbs result;
+            for (int i = 0; i < n; i += m) {
+                Limbs slice(a.begin() + i, a.begin() + min(n, i + m));
+                Trim(slice);
+                AddShifted(result, MultiplyKaratsuba(slice, b), i);
+            }
+            Trim(result);
+            return result;
+        }
+        int h = n / 2;
+        Limbs a0(a.begin(), a.begin() + h), a1(a.begin() + h, a.end());
+        Limbs b0(b.begin(), b.begin() + h), b1(b.begin() + h, b.end());
+        Trim(a0);
+        Trim(b0);
+        auto z0 = MultiplyKaratsuba(a0, b0);
+        auto z2 = MultiplyKaratsuba(a1, b1);
+        AddShifted(a0, a1, 0);
+        AddShifted(b0, b1, 0);
+        auto z1 = MultiplyKaratsuba(a0, b0);
+        Subtract(z1, z0);
+        Subtract(z1, z2);
+        AddShifted(z0, z1, h);
+        AddShifted(z0, z2, 2 * h);
+        Trim(z0);
+        return z0;
+    }
+
+    // Splits the limbs into 32-bit digits, so the convolution stays within
+    // the range of the NTT.
+    static Limbs MultiplyNtt(const Limbs& a, const Limbs& b) {
+        auto split = [](const Limbs& a) {
+            vector<uint32_t> digits(2 * a.size());
+            for (size_t i = 0; i < a.size(); ++i) {
+                digits[2*i] = (uint32_t)a[i];
+                digits[2*i+1] = a[i] >> 32;
+            }
+            return digits;
+        };
+        auto c = ntt::Convolve(split(a), split(b));
+        Limbs result(c.size() / 2 + 2);
+        uint128 carry = 0;
+        for (size_t i = 0; i < c.size() || carry; ++i) {
+            uint128 cur = carry + (i < c.size() ? c[i] : 0);
+            result[i/2] |= (uint64)(uint32_t)cur << (i % 2 * 32);
+            carry = cur >> 32;
+        }
+        Trim(result);
+        return result;
+    }
+
+    static Limbs Multiply(const Limbs& a, const Limbs& b) {
+        if (min(a.size(), b.size()) < (size_t)kKaratsubaLimbs) {
+            return MultiplySchool(a, b);
+        }
+        if (min(a.size(), b.size()) < (size_t)kNttLimbs) {
+            return MultiplyKaratsuba(a, b);
+        }
+        return MultiplyNtt(a, b);
+    }
+
+    // x / 2^(64 * from), from the three leading limbs of x.
+    static long double Leading(const Huge& x, int from) {
+        long double r = 0;
+        int i = x.size() - 1;
+        for (int taken = 0; i >= from && taken < 3; --i, ++taken) {
+            r = ldexpl(r, 64) + x[i];
+        }
+        return ldexpl(r, 64 * (i + 1 - from));
+    }
+
+    // Long division; each quotient limb is estimated from the leading limbs
+    // and corrected by at most a few subtractions.
+    Huge DivideSchool(const Huge& div) {
+        Huge rem, sub;
+        int m = div.size(), from = max(0, m - 3);
+        long double top = Leading(div, from);
+        for (int i = size() - 1; i >= 0; --i) {
+            rem <<= 1;
+            rem[0] = v[i];
+            rem.Trim();
+            uint64 q = 0;
+            if (rem.size() >= m) {
+                long double estimate = Leading(rem, from) / top;
+                q = estimate >= ldexpl(1, 64) ? ~0ULL : (uint64)estimate;
+                sub = div;
+                MultiplySmall(sub.v, q);
+                while (sub > rem) {
+                    --q;
+                    sub -= div;
+                }
+                rem -= sub;
+                while (rem >= div) {
+                    ++q;
+                    rem -= div;
+                }
+            }
+            v[i] = q;
+        }
+        Trim();
+        return rem;
+    }
+
+    // floor(2^(128 * size) / b) up to a few units, refined from a
+    // reciprocal of the leading half of b by one Newton step.
+    static Huge Reciprocal(const Huge& b) {
+        int n = b.size();
+        Huge p(1);
+        p <<= 2 * n;
+        if (n <= kNewtonLimbs) {
+            p.DivideSchool(b);
+            return p;
+        }
+        int h = n / 2 + 2;
+        Huge x = b;
+        x >>= n - h;
+        x = Reciprocal(x);
+        x <<= n - h;
+        Huge bx = b * x;
+        if (bx <= p) {
+            Huge t = x * (p - bx);
+            t >>= 2 * n;
+            x += t;
+        } else {
+            Huge t = x * (bx - p);
+            t >>= 2 * n;
+            x -= t;
+        }
+        return x;
+    }
+
+    // Divisors are scaled to l limbs, which must be at least the divisor's
+    // size and two more than the quotient's, before taking the reciprocal.
+    static Huge Scale(const Huge& x, int m, int l) {
+        Huge result = x;
+        if (m < l) {
+            result <<= l - m;
+        } else {
+            result >>= m - l;
+        }
+        return result;
+    }
+
+    // Division given r = Reciprocal(Scale(div, div.size(), l)).
+    Huge DivideByReciprocal(const Huge& div, const Huge& r, int l) {
+        Huge q = Scale(*this, div.size(), l) * r;
+        q >>= 2 * l;
+        Huge prod = q * div;
+        while (prod > *this) {
+            q -= 1;
+            prod -= div;
+        }
+        Huge rem = *this - prod;
+        while (rem >= div) {
+            q += 1;
+            rem -= div;
+        }
+        *this = q;
+        return rem;
+    }
+
+    Huge DivideNewton(const Huge& div) {
+        int m = div.size();
+        int l = max(m, size() - m + 3);
+        return DivideByReciprocal(div, Reciprocal(Scale(div, m, l)), l);
+    }
+
+    // 10^(kChunkDigits * 2^k), computed by repeated squaring and cached.
+    // Any thread may call it: missing levels are filled in under a lock
+    // and published through ready, and a filled level never changes, so
+    // the returned reference stays valid.
+    static const Huge& DecimalPower(int k) {
+        static Huge powers[kDecimalLevels];
+        static atomic<int> ready(0);
+        static mutex lock;
+        if (k >= ready.load(memory_order_acquire)) {
+            lock_guard<mutex> guard(lock);
+            for (int i = ready.load(memory_order_relaxed); i <= k; ++i) {
+                powers[i] = i ? powers[i - 1] * powers[i - 1] : Huge(kChunk);
+                ready.store(i + 1, memory_order_release);
+            }
+        }
+        return powers[k];
+    }
+
+    // The reciprocal of DecimalPower(k) for dividing anything below its
+    // square, so every division on one level of ToDecimal shares it.
+    // Cached the same way as DecimalPower.
+    static const Huge& DecimalReciprocal(int k) {
+        static Huge reciprocals[kDecimalLevels];
+        static atomic<int> ready(0);
+        static mutex lock;
+        if (k >= ready.load(memory_order_acquire)) {
+            lock_guard<mutex> guard(lock);
+            for (int i = ready.load(memory_order_relaxed); i <= k; ++i) {
+                const Huge& p = DecimalPower(i);
+                reciprocals[i] = Reciprocal(Scale(p, p.size(), p.size() + 3));
+                ready.store(i + 1, memory_order_release);
+            }
+        }
+        return reciprocals[k];
+    }
+
+    // Writes the digits of |x| < DecimalPower(k) to out, padded with zeros
+    // to kChunkDigits * 2^k digits. The halves split by DecimalPower(k - 1)
+    // are independent, so they are converted in parallel while there are
+    // threads to spare.
+    static void WriteDecimal(const Huge& x, int k, char* out, int threads) {
+        if (k <= kDecimalLevel) {
+            Huge y = x;
+            y.negative = false;
+            for (char* end = out + (kChunkDigits << k); end > out; end -= kChunkDigits) {
+                int64 chunk = y /= kChunk;
+                for (int i = 1; i <= kChunkDigits; ++i, chunk /= 10) {
+                    end[-i] = '0' + chunk % 10;
+                }
+            }
+            return;
+        }
+        const Huge& p = DecimalPower(k - 1);
+        Huge q = x, r;
+        q.negative = false;
+        if (p.size() >= kNewtonLimbs) {
+            r = q.DivideByReciprocal(p, DecimalReciprocal(k - 1), p.size() + 3);
+        } else {
+            r = q /= p;
+        }
+        char* low = out + (kChunkDigits << (k - 1));
+        if (threads > 1 && x.size() >= kParallelLimbs) {
+            thread high([&] { WriteDecimal(q, k - 1, out, threads / 2); });
+            WriteDecimal(r, k - 1, low, threads - threads / 2);
+            high.join();
+        } else {
+            WriteDecimal(q, k - 1, out, 1);
+            WriteDecimal(r, k - 1, low, 1);
+        }
+    }
+
+    // The decimal representation, written into one buffer.
+    string Decimal(int threads) const {
+        int k = 0;
+        while (CompareMagnitude(DecimalPower(k).v, v) <= 0) {
+            ++k;
+        }
+        // Filled up front, so the threads below only read the caches.
+        if (k > 0) {
+            DecimalReciprocal(k - 1);
+        }
+        string s(negative + (kChunkDigits << k), '-');
+        WriteDecimal(*this, k, &s[negative], threads);
+        size_t zeros = s.find_first_not_of('0', negative) - negative;
+        s.erase(negative, min(zeros, s.size() - negative - 1));
+        return s;
+    }
+
+    // The value of the decimal digits s[0, len), by splitting off the low
+    // kChunkDigits * 2^k digits.
+    static Huge FromDecimal(const char* s, int len, int threads) {
+        Huge result;
+        if (len <= kChunkDigits << kDecimalLevel) {
+            for (int i = 0; i < len; ) {
+                int take = (len - i) % kChunkDigits ? (len - i) % kChunkDigits : kChunkDigits;
+                int64 chunk = 0, scale = 1;
+                for (int j = 0; j < take; ++j, ++i) {
+                    chunk = chunk * 10 + (s[i] - '0');
+                    scale *= 10;
+                }
+                MultiplySmall(result.v, scale);
+                result += chunk;
+            }
+            return result;
+        }
+        int k = DecimalLevel(len);
+        int low = kChunkDigits << k;
+        Huge high, rest;
+        // A limb holds about 19 decimal digits.
+        if (threads > 1 && low >= 19 * kParallelLimbs) {
+            thread worker([&] { high = FromDecimal(s, len - low, threads / 2); });
+            rest = FromDecimal(s + len - low, low, threads - threads / 2);
+            worker.join();
+        } else {
+            high = FromDecimal(s, len - low, 1);
+            rest = FromDecimal(s + len - low, low, 1);
+        }
+        result = high * DecimalPower(k);
+        result += rest;
+        return result;
+    }
+
+    // The level at which FromDecimal splits len digits.
+    static int DecimalLevel(int len) {
+        int k = kDecimalLevel;
+        while ((kChunkDigits << (k + 1)) < len) {
+            ++k;
+        }
+        return k;
+    }
+
+    static int Threads() {
+        return max(1u, thread::hardware_concurrency());
+    }
+
+    static uint64 Magnitude(int64 x) {
+        return x < 0 ? -(uint64)x : x;
+    }
+
+    Huge DivideMagnitude(const Huge& div) {
+        if (CompareMagnitude(v, div.v) < 0) {
+            Huge rem = move(*this);
+            v.clear();
+            return rem;
+        }
+        if (min(div.size(), size() - div.size() + 1) >= kNewtonLimbs) {
+            return DivideNewton(div);
+        }
+        return DivideSchool(div);
     }
-    static const int kBase;
-    vector<int64> v;
 
   public:
     inline int size() const {
         return (int)v.size();
     }
 
-    void Append(int64 x) {
-        while (x) {
-            v.push_back(x % kBase);
-            x /= kBase;
+    void Append(uint64 x) {
+        if (x) {
+            v.push_back(x);
         }
     }
 
     void Trim() {
-        while (size() > 0 && v.back() == 0) {
-            v.pop_back();
-        }
+        Trim(v);
     }
 
     Huge() {}
 
     Huge(int64 x) {
-        v.clear();
-        Append(x);
+        negative = x < 0;
+        Append(Magnitude(x));
     }
 
-    int64& operator [] (int x) {
+    // Parses decimal digits with an optional sign. Long inputs convert
+    // their halves on up to `threads` threads.
+    explicit Huge(const string& s, int threads = Threads()) {
+        size_t sign = !s.empty() && (s[0] == '-' || s[0] == '+');
+        DecimalPower(DecimalLevel(s.size() - sign));
+        *this = FromDecimal(s.data() + sign, s.size() - sign, threads);
+        negative = sign && s[0] == '-';
+        Normalize();
+    }
+
+    uint64& operator [] (int x) {
         return v[x];
     }
 
-    int64 operator [] (int x) const {
+    uint64 operator [] (int x) const {
         return v[x];
     }
 
+    bool IsNegative() const {
+        return negative;
+    }
+
     bool operator < (const Huge& other) const {
-        if (other.size() != size()) {
-            return size() < other.size();
+        if (negative != other.negative) {
+            return negative;
         }
-        for (int i = size()-1; i >= 0; --i) {
-            if (v[i] != other[i]) {
-                return v[i] < other[i];
-            }
-        }
-        return false;
+        int c = CompareMagnitude(v, other.v);
+        return negative ? c > 0 : c < 0;
     }
 
     bool operator > (const Huge& other) const {
-        if (other.size() != size()) {
-            return size() > other.size();
-        }
-        for (int i = size()-1; i >= 0; --i) {
-            if (v[i] != other[i]) {
-                return v[i] > other[i];
-            }
-        }
-        return false;
+        return other < *this;
     }
 
     bool operator <= (const Huge& other) const {
@@ -83,100 +852,95 @@ class Huge {
         return !(*this < other);
     }
 
-    bool operator == (const Huge& other) {
-        return v == other.v;
+    bool operator == (const Huge& other) const {
+        return negative == other.negative && v == other.v;
     }
 
-    bool operator != (const Huge& other) {
-        return v != other.v;
+    bool operator != (const Huge& other) const {
+        return !(*this == other);
     }
 
+    // Shifts by whole limbs, that is multiplies or divides by 2^(64 * x).
     void operator <<= (int x) {
-        v.insert(v.begin(), x, 0);
+        size_t n = v.size();
+        v.resize(n + x);
+        copy_backward(v.begin(), v.begin() + n, v.end());
+        fill(v.begin(), v.begin() + x, 0);
     }
 
     void operator >>= (int x) {
-        v.erase(v.begin(), v.begin() + x);
-    }   
+        x = min(x, size());
+        copy(v.begin() + x, v.end(), v.begin());
+        v.resize(v.size() - x);
+        Normalize();
+    }
 
     void operator += (const Huge& other) {
-        int sz = max(other.size(), size());
-        v.resize(sz);
-
-        int transport = 0;
-        for (int i = 0; i < other.size() || (i < size() && transport); ++i) {
-            v[i] += (i < other.size() ? other[i] : 0) + transport;
-            if (v[i] >= kBase) {
-                transport = 1;
-                v[i] -= kBase;
-            } else {
-                transport = 0;
-            }
-        }
+        MulAccumulate(other.v, 1, other.negative);
+    }
 
-        Append(transport);
+    void operator -= (const Huge& other) {
+        MulAccumulate(other.v, 1, !other.negative);
     }
 
-    Huge operator + (const Huge& other) const {
-        Huge result = *this;
-        result += other;
-        return result;
+    // *this += b * m and *this -= b * m, without a temporary for the product.
+    void AddMul(const Huge& b, int64 m) {
+        MulAccumulate(b.v, Magnitude(m), b.negative != (m < 0));
     }
 
-    void operator -= (const Huge& other) {
-        int transport = 0;
-        for (int i = 0; i < other.size() || (i < size() && transport); ++i) {
-            v[i] -= (i < other.size() ? other[i] : 0) + transport;
-            if (v[i] < 0) {
-                v[i] += kBase;
-                transport = 1;
-            } else {
-                transport = 0;
-            }
-        }
-        if (transport) {
-            cerr << "You tried to make a negative number! Not supported!";
-        }
-        Trim();
+    void SubMul(const Huge& b, int64 m) {
+        MulAccumulate(b.v, Magnitude(m), b.negative == (m < 0));
     }
 
-    Huge operator - (const Huge& other) const {
-        Huge result = *this;
-        result -= other;
-        return result;
+    // The left operand is taken by value, so temporaries are reused.
+    friend Huge operator + (Huge a, const Huge& b) {
+        a += b;
+        return a;
     }
 
-    Huge operator * (const Huge& other) const {
-        Huge result;
-        result.v.resize(size() + other.size());
-        for (int i = 0; i < size(); ++i) {
-            for (int j = 0; j < other.size(); ++j) {
-                result[i+j] += v[i] * other[j];
-                for (int k = i+j; result[k] >= kBase; ++k) {
-                    result[k+1] += result[k] / kBase;
-                    result[k] %= kBase;
-                }
-            }
-        }
+    friend Huge operator - (Huge a, const Huge& b) {
+        a -= b;
+        return a;
+    }
 
-        result.Trim();
+    friend Huge operator - (Huge a) {
+        a.negative = !a.negative;
+        a.Normalize();
+        return a;
+    }
 
+    Huge operator * (const Huge& other) const {
+        Huge result;
+        result.v = Multiply(v, other.v);
+        result.negative = negative != other.negative;
+        result.Normalize();
         return result;
     }
 
     void operator *= (const Huge& other) {
-        *this = *this * other;
+        if (other.size() == 1) {
+            MultiplySmall(v, other[0]);
+        } else {
+            v = Multiply(v, other.v);
+        }
+        negative = negative != other.negative;
+        Normalize();
     }
 
+    // Divisions truncate towards zero and the remainder takes the sign of
+    // the dividend, as for built-in integers.
     int64 operator /= (int64 div) {
-        int64 rem = 0;
+        uint64 d = Magnitude(div);
+        uint128 rem = 0;
         for (int i = size() - 1; i >= 0; --i) {
-            rem = rem * kBase + v[i];
-            v[i] = rem / div;
-            rem %= div;
+            rem = rem << 64 | v[i];
+            v[i] = rem / d;
+            rem %= d;
         }
-        Trim();
-        return rem;
+        bool remNegative = negative;
+        negative = negative != (div < 0);
+        Normalize();
+        return remNegative ? -(int64)rem : (int64)rem;
     }
 
     pair<Huge, int64> operator / (int64 div) const {
@@ -186,23 +950,24 @@ class Huge {
     }
 
     Huge operator /= (const Huge& div) {
+        // The division overwrites *this while it still reads div.
+        if (&div == this) {
+            Huge copy = div;
+            return *this /= copy;
+        }
+        bool remNegative = negative;
+        bool quotientNegative = negative != div.negative;
+        negative = false;
         Huge rem;
-        for (int i = size() - 1; i >= 0; --i) {
-            rem <<= 1;
-            rem[0] = v[i];
-            int64 lo = 0, hi = kBase;
-            while (hi - lo > 1) {
-                int64 mid = (hi + lo) >> 1;
-                if (div * mid <= rem) {
-                    lo = mid;
-                } else {
-                    hi = mid;
-                }
-            }
-            v[i] = lo;
-            rem -= div * lo;
+        if (div.negative) {
+            rem = DivideMagnitude(-div);
+        } else {
+            rem = DivideMagnitude(div);
         }
-        Trim();
+        negative = quotientNegative;
+        Normalize();
+        rem.negative = remNegative;
+        rem.Normalize();
         return rem;
     }
 
@@ -212,33 +977,71 @@ class Huge {
         return {result, rem};
     }
 
+    // Writes the decimal representation straight to a file. Long numbers
+    // convert their halves on up to `threads` threads.
+    void Print(FILE* out, int threads = Threads()) const {
+        string s = Decimal(threads);
+        fwrite(s.data(), 1, s.size(), out);
+    }
+
     friend ostream& operator << (ostream& out, const Huge& huge);
+    friend istream& operator >> (istream& in, Huge& huge);
 };
 
-const int Huge::kBase = Huge::pw10(Huge::kLogBase);
-
 ostream& operator << (ostream& out, const Huge& huge) {
-    if (huge.size() == 0) {
-        out << '0';
-        return out;
-    }
+    string s = huge.Decimal(Huge::Threads());
+    return out.write(s.data(), s.size());
+}
+
+istream& operator >> (istream& in, Huge& huge) {
     string s;
-    for (int i = 0; i < huge.size(); ++i) {
-        int64 x = huge[i];
-        for (int j = 0; j < Huge::kLogBase; ++j) {
-            s += (char)(x % 10 + '0');
-            x /= 10;
-        }
-    }
-    // out << s << "\n";
-    while (s.size() > 0 && s.back() == '0')
-        s.pop_back();
-    reverse(s.begin(), s.end());
-    out << s;
-    return out;
+    if (in >> s) {
+        huge = Huge(s);
+    }
+    return in;
 }
 
-int main() {
+// Counts allocations for the check in main.
+long allocations = 0;
 
+void* operator new(size_t size) {
+    ++allocations;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+int main() {
+    Huge h = Huge(123456789) * Huge(-987654321);
+    Huge k = Huge("-121932631112635269");
     cout << (h == k);
+
+    // Dividing a number by itself.
+    Huge x = Huge("154180540029432988592755103815279543320353238875239330981");
+    Huge r = x /= x;
+    cout << (x == 1 && r == 0);
+
+    // Arithmetic on values below 2^128 stays in the inline limbs.
+    Huge a = Huge(1LL << 62) * Huge(1LL << 30), b = -a, c(1000000007);
+    long before = allocations;
+    b /= 3;
+    Huge s = a;
+    s -= b;
+    s += c;
+    s = a * c;
+    s /= c;
+    s.SubMul(a, 2);
+    s.AddMul(b, 5);
+    Huge q = a;
+    q /= b;
+    cout << (allocations == before);
 }
@@ -1,5 +1,10 @@
 #include <iostream>
 #include <vector>
+#include <array>
+#include <cstdint>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
@@ -7,130 +12,418 @@ typedef long long int64;
 
 const int kMod = 1e9+7;
 
-template<int M = kMod>
-struct Mod {
-    int64 x;
-    
-    static void Euclidean(int64 a, int64 b, int64& x, int64& y) {
-        if (b == 0) {
-            x = 1;
-            y = 0;
-            return;
-        }
-        int64 x0, y0;
-        Euclidean(b, a%b, x0, y0);
-        x = y0;
-        y = x0 - a/b * y0;   
+// -m^-1 modulo 2^32 for odd m, by Newton's iteration.
+constexpr uint32_t montgomeryInverse(uint32_t m) {
+    uint32_t inv = m;
+    for (int i = 0; i < 5; ++i) {
+        inv *= 2 - m * inv;
     }
-    
-    Mod() : x(0) {}
-    
-    Mod(int64 x) : x(x) {
-        if (this->x >= M)
-            this->x %= M;
-        if (this->x < 0)
-            this->x += M;
+    return -inv;
+}
+
+// Constants for Montgomery form, used by the batch operations. Montgomery
+// form needs an odd modulus; even ones take the scalar path.
+struct Montgomery {
+    bool ok;
+    uint32_t inverse;
+    // 2^32 and 2^64 modulo the modulus.
+    uint32_t r, r2;
+
+    constexpr Montgomery(uint32_t m)
+        : ok(m % 2 == 1), inverse(montgomeryInverse(m)),
+          r((1ULL << 32) % m), r2((-(uint64_t)m) % m) {}
+};
+
+// A modulus M < 2^31 fixed at compile time. Everything built on it folds
+// into constants and works in constant expressions.
+template<int M>
+struct StaticModulus {
+    static constexpr uint32_t mod() {
+        return M;
     }
-    
-    bool operator == (const Mod<M>& other) {
+
+    // floor((2^64 - 1) / M).
+    static constexpr uint64_t barrett() {
+        return ~0ULL / M;
+    }
+
+    static constexpr Montgomery montgomery() {
+        return Montgomery(M);
+    }
+};
+
+// A modulus below 2^31 chosen at runtime with Set, which precomputes its
+// Barrett and Montgomery constants. Each Id holds its own modulus, so
+// residues modulo different runtime moduli keep different types.
+template<int Id = 0>
+struct DynamicModulus {
+    static void Set(uint32_t m) {
+        modulus = m;
+        inverse = ~0ULL / m;
+        constants = Montgomery(m);
+    }
+
+    static uint32_t mod() {
+        return modulus;
+    }
+
+    static uint64_t barrett() {
+        return inverse;
+    }
+
+    static const Montgomery& montgomery() {
+        return constants;
+    }
+
+  private:
+    static inline uint32_t modulus = 1;
+    static inline uint64_t inverse = ~0ULL;
+    static inline Montgomery constants = Montgomery(1);
+};
+
+// Residues modulo P::mod() < 2^31, kept in [0, mod) in 32 bits. Products
+// are reduced with Barrett's method, so no operation divides at runtime.
+template<typename P>
+struct ModInt {
+    uint32_t x;
+
+    // t mod P::mod() for t < 2^62, which covers products of residues. The
+    // estimated quotient is then at most one too small, so one conditional
+    // subtraction finishes the reduction.
+    static constexpr uint32_t Reduce(uint64_t t) {
+        uint64_t q = (unsigned __int128)t * P::barrett() >> 64;
+        uint64_t r = t - q * P::mod();
+        return r >= P::mod() ? r - P::mod() : r;
+    }
+
+    // Wraps a value already in [0, mod).
+    static constexpr ModInt<P> Raw(uint32_t x) {
+        ModInt<P> result;
+        result.x = x;
+        return result;
+    }
+
+    constexpr ModInt() : x(0) {}
+
+    // Any 64-bit value: the quotient estimate may be two too small here.
+    constexpr ModInt(int64 v) : x(0) {
+        uint32_t m = P::mod();
+        uint64_t u = v < 0 ? -(uint64_t)v : v;
+        uint64_t r = u - (uint64_t)((unsigned __int128)u * P::barrett() >> 64) * m;
+        r = r >= m ? r - m : r;
+        r = r >= m ? r - m : r;
+        x = v < 0 && r ? m - r : r;
+    }
+
+    constexpr bool operator == (const ModInt<P>& other) const {
         return x == other.x;
     }
-    
-    bool operator != (const Mod<M>& other) {
+
+    constexpr bool operator != (const ModInt<P>& other) const {
         return x != other.x;
     }
-    
-    void operator += (const Mod<M>& other) {
+
+    // With mod < 2^31 the sum fits, and min picks the reduced value.
+    constexpr void operator += (const ModInt<P>& other) {
         x += other.x;
-        if (x >= M)
-            x -= M;
+        x = min(x, x - P::mod());
     }
-    
-    Mod<M> operator + (const Mod<M>& other) const {
-        Mod<M> result = *this;
+
+    constexpr ModInt<P> operator + (const ModInt<P>& other) const {
+        ModInt<P> result = *this;
         result += other;
         return result;
     }
-    
-    void operator -= (const Mod<M>& other) {
+
+    constexpr void operator -= (const ModInt<P>& other) {
         x -= other.x;
-        if (x < 0)
-            x += M;
+        x = min(x, x + P::mod());
     }
-    
-    Mod<M> operator - (const Mod<M>& other) const {
-        Mod<M> result = *this;
+
+    constexpr ModInt<P> operator - (const ModInt<P>& other) const {
+        ModInt<P> result = *this;
         result -= other;
         return result;
     }
-    
-    void operator *= (const Mod<M>& other) {
-        x *= other.x;
-        x %= M;
+
+    constexpr void operator *= (const ModInt<P>& other) {
+        x = Reduce((uint64_t)x * other.x);
     }
-    
-    Mod<M> operator * (const Mod<M>& other) const {
-        Mod<M> result = *this;
+
+    constexpr ModInt<P> operator * (const ModInt<P>& other) const {
+        ModInt<P> result = *this;
         result *= other;
         return result;
     }
-    
-    Mod<M> Inv() const {
-        int64 a, b;
-        Euclidean(x, M, a, b);
-        return a;
+
+    // Iterative extended Euclid on (x, mod), keeping only the coefficient
+    // of x.
+    constexpr ModInt<P> Inv() const {
+        int64 a = x, b = P::mod(), u = 1, v = 0;
+        while (b) {
+            int64 q = a / b;
+            int64 t = a - q * b;
+            a = b;
+            b = t;
+            t = u - q * v;
+            u = v;
+            v = t;
+        }
+        return u;
     }
-    
-    Mod<M> operator - () const {
-        Mod<M> result = *this;
-        result.x = M - result.x;
-        return result;
+
+    constexpr ModInt<P> operator - () const {
+        return Raw(x ? P::mod() - x : 0);
     }
-    
-    void operator /= (const Mod<M>& other) {
+
+    constexpr void operator /= (const ModInt<P>& other) {
         *this *= other.Inv();
     }
-    
-    Mod<M> operator / (const Mod<M>& other) const {
-        Mod<M> result = *this;
+
+    constexpr ModInt<P> operator / (const ModInt<P>& other) const {
+        ModInt<P> result = *this;
         result /= other;
         return result;
     }
 };
 
 template<int M = kMod>
-ostream& operator << (ostream& out, const Mod<M>& m) {
+using Mod = ModInt<StaticModulus<M>>;
+
+template<int Id = 0>
+using DynamicMod = ModInt<DynamicModulus<Id>>;
+
+template<typename P>
+ostream& operator << (ostream& out, const ModInt<P>& m) {
     out << m.x;
     return out;
 }
 
-template<int M = kMod>
-istream& operator >>(istream& in, const Mod<M>& m) {
-    in >> m.x;
+template<typename P>
+istream& operator >>(istream& in, ModInt<P>& m) {
+    int64 v;
+    in >> v;
+    m = v;
     return in;
 }
 
 
-template<int M = kMod>
-Mod<M> operator + (int64 x, const Mod<M>& other) {
+template<typename P>
+constexpr ModInt<P> operator + (int64 x, const ModInt<P>& other) {
     return other + x;
 }
 
-template<int M = kMod>
-Mod<M> operator - (int64 x, const Mod<M>& other) {
+template<typename P>
+constexpr ModInt<P> operator - (int64 x, const ModInt<P>& other) {
     return x + (-other);
 }
 
-template<int M = kMod>
-Mod<M> operator * (int64 x, const Mod<M>& other) {
+template<typename P>
+constexpr ModInt<P> operator * (int64 x, const ModInt<P>& other) {
     return other * x;
 }
 
-template<int M = kMod>
-Mod<M> operator / (int64 x, const Mod<M>& other) {
+template<typename P>
+constexpr ModInt<P> operator / (int64 x, const ModInt<P>& other) {
     return other.Inv() * x;
 }
 
+// Batch operations over arrays of residues. With AVX2 they work on eight
+// residues per register, multiplying in Montgomery form as in fft.cpp;
+// other CPUs and the tails of arrays take the scalar path.
+namespace simd {
+
+#if defined(__x86_64__)
+bool enabled() {
+    static const bool ok = __builtin_cpu_supports("avx2");
+    return ok;
+}
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+
+// a * b * 2^-32 modulo mod, for a * b < mod * 2^32 and mod < 2^31.
+// mod and modInv = -mod^-1 modulo 2^32 are broadcast to every lane.
+inline __m256i mul(__m256i a, __m256i b, __m256i mod, __m256i modInv) {
+    __m256i tEven = _mm256_mul_epu32(a, b);
+    __m256i tOdd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), _mm256_srli_epi64(b, 32));
+    __m256i uEven = _mm256_add_epi64(tEven,
+        _mm256_mul_epu32(_mm256_mul_epu32(tEven, modInv), mod));
+    __m256i uOdd = _mm256_add_epi64(tOdd,
+        _mm256_mul_epu32(_mm256_mul_epu32(tOdd, modInv), mod));
+    __m256i u = _mm256_blend_epi32(_mm256_srli_epi64(uEven, 32), uOdd, 0xAA);
+    return _mm256_min_epu32(u, _mm256_sub_epi32(u, mod));
+}
+
+// The loops below need n to be a multiple of 8.
+
+// out = a * b. Plain residues lose a factor 2^32 in the first Montgomery
+// product, which the second one, by r2 = 2^64 modulo mod, puts back.
+void mul(uint32_t* out, const uint32_t* a, const uint32_t* b, int n,
+    uint32_t modulus, uint32_t inverse, uint32_t r2) {
+    __m256i mod = _mm256_set1_epi32(modulus);
+    __m256i modInv = _mm256_set1_epi32(inverse);
+    __m256i scale = _mm256_set1_epi32(r2);
+    for (int i = 0; i < n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i p = mul(mul(x, y, mod, modInv), scale, mod, modInv);
+        _mm256_storeu_si256((__m256i*)(out + i), p);
+    }
+}
+
+// a *= c, with c given as c * 2^32 modulo mod.
+void scale(uint32_t* a, int n, uint32_t c, uint32_t modulus, uint32_t inverse) {
+    __m256i mod = _mm256_set1_epi32(modulus);
+    __m256i modInv = _mm256_set1_epi32(inverse);
+    __m256i factor = _mm256_set1_epi32(c);
+    for (int i = 0; i < n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        _mm256_storeu_si256((__m256i*)(a + i), mul(x, factor, mod, modInv));
+    }
+}
+
+void add(uint32_t* out, const uint32_t* a, const uint32_t* b, int n, uint32_t modulus) {
+    __m256i mod = _mm256_set1_epi32(modulus);
+    for (int i = 0; i < n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i s = _mm256_add_epi32(x, y);
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_min_epu32(s, _mm256_sub_epi32(s, mod)));
+    }
+}
+
+// The sum of a[i] * b[i] * 2^-32 modulo mod, unreduced. The products stay
+// below 2^31 and are summed in 64-bit lanes.
+uint64_t dot(const uint32_t* a, const uint32_t* b, int n, uint32_t modulus, uint32_t inverse) {
+    __m256i mod = _mm256_set1_epi32(modulus);
+    __m256i modInv = _mm256_set1_epi32(inverse);
+    __m256i low = _mm256_set1_epi64x(0xFFFFFFFF);
+    __m256i even = _mm256_setzero_si256(), odd = _mm256_setzero_si256();
+    for (int i = 0; i < n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i p = mul(x, y, mod, modInv);
+        even = _mm256_add_epi64(even, _mm256_and_si256(p, low));
+        odd = _mm256_add_epi64(odd, _mm256_srli_epi64(p, 32));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, _mm256_add_epi64(even, odd));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+#pragma GCC pop_options
+#else
+bool enabled() {
+    return false;
+}
+
+void mul(uint32_t*, const uint32_t*, const uint32_t*, int, uint32_t, uint32_t, uint32_t) {}
+void scale(uint32_t*, int, uint32_t, uint32_t, uint32_t) {}
+void add(uint32_t*, const uint32_t*, const uint32_t*, int, uint32_t) {}
+uint64_t dot(const uint32_t*, const uint32_t*, int, uint32_t, uint32_t) {
+    return 0;
+}
+#endif
+
+}
+
+// The residues of an array of ModInt, which is just their storage.
+template<typename P>
+uint32_t* Residues(ModInt<P>* a) {
+    return reinterpret_cast<uint32_t*>(a);
+}
+
+template<typename P>
+const uint32_t* Residues(const ModInt<P>* a) {
+    return reinterpret_cast<const uint32_t*>(a);
+}
+
+// out[i] = a[i] * b[i]; out may be a or b.
+template<typename P>
+void BatchMul(ModInt<P>* out, const ModInt<P>* a, const ModInt<P>* b, int n) {
+    const Montgomery mont = P::montgomery();
+    int i = 0;
+    if (mont.ok && simd::enabled()) {
+        i = n / 8 * 8;
+        simd::mul(Residues(out), Residues(a), Residues(b), i, P::mod(), mont.inverse, mont.r2);
+    }
+    for (; i < n; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+// out[i] = a[i] + b[i]; out may be a or b.
+template<typename P>
+void BatchAdd(ModInt<P>* out, const ModInt<P>* a, const ModInt<P>* b, int n) {
+    int i = 0;
+    if (simd::enabled()) {
+        i = n / 8 * 8;
+        simd::add(Residues(out), Residues(a), Residues(b), i, P::mod());
+    }
+    for (; i < n; ++i) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+// The sum of a[i] * b[i].
+template<typename P>
+ModInt<P> Dot(const ModInt<P>* a, const ModInt<P>* b, int n) {
+    ModInt<P> result;
+    const Montgomery mont = P::montgomery();
+    int i = 0;
+    if (mont.ok && simd::enabled()) {
+        i = n / 8 * 8;
+        // Each product carries a factor 2^-32, removed once at the end.
+        uint64_t sum = simd::dot(Residues(a), Residues(b), i, P::mod(), mont.inverse);
+        result = ModInt<P>(sum % P::mod()) * ModInt<P>::Raw(mont.r);
+    }
+    for (; i < n; ++i) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+
+// a[i] = a[0] * ... * a[i]. The array is cut into eight blocks whose
+// running products are independent, so their multiplications overlap
+// instead of waiting on each other. Each block is then scaled by the
+// product of the blocks before it, eight residues at a time.
+template<typename P>
+void PrefixProducts(ModInt<P>* a, int n) {
+    const Montgomery mont = P::montgomery();
+    const int kBlocks = 8;
+    int len = n / kBlocks;
+    if (len == 0) {
+        for (int i = 1; i < n; ++i) {
+            a[i] *= a[i-1];
+        }
+        return;
+    }
+    for (int i = 1; i < len; ++i) {
+        for (int j = 0; j < kBlocks; ++j) {
+            a[j*len + i] *= a[j*len + i - 1];
+        }
+    }
+    for (int i = kBlocks * len; i < n; ++i) {
+        a[i] *= a[i-1];
+    }
+    ModInt<P> carry = a[len-1];
+    for (int j = 1; j < kBlocks; ++j) {
+        ModInt<P>* block = a + j*len;
+        int size = j == kBlocks - 1 ? n - j*len : len;
+        ModInt<P> total = carry * block[len-1];
+        int i = 0;
+        if (mont.ok && simd::enabled()) {
+            i = size / 8 * 8;
+            simd::scale(Residues(block), i, (carry * ModInt<P>::Raw(mont.r)).x, P::mod(), mont.inverse);
+        }
+        for (; i < size; ++i) {
+            block[i] *= carry;
+        }
+        carry = total;
+    }
+}
+
 template<int M = kMod>
 class Combinatorics {
     vector<Mod<M>> fac, inv_fac;    
@@ -178,4 +471,18 @@ int main() {
     m = 3 + m;
 
     cout << m;
+
+    constexpr auto inverses = [] {
+        array<Mod<>, 10> table{};
+        for (int i = 1; i < 10; ++i) {
+            table[i] = Mod<>(i).Inv();
+        }
+        return table;
+    }();
+    static_assert(inverses[7] * 7 == 1, "");
+
+    DynamicModulus<>::Set(998244353);
+    DynamicMod<> d(-5);
+
+    cout << d / 2;
 }
\ No newline at end of file
@@ -1,85 +1,120 @@
-
-// Constructs the dual of a planar graph on N vertices with specified edges.
-// addOuterFace=true has not been thouroughly tested.
-// You have to modify the lambda function for sorting the neighbours of a vertex in a circular order.
+// Constructs the dual of a planar subdivision given as half-edges (see
+// HalfEdgeMesh in geometry.cpp). Every face is traced once by following
+// next, a single linear pass. addOuterFace=false drops the face containing
+// mesh.outer. For the Delaunay triangulation the dual is the Voronoi diagram.
 // Returns pair of (lists of indices of points sorrounding each face in circular order,
 //                  list of ordered edges between faces. Ordered means (x, y) will also appear as (y, x))
 // Two faces are connected by an edge in the dual if they are neighbouring in the primal.
 pair<vector<vector<int>>, vector<pair<int,int>>> buildDual(
-    int n, vector<pair<int,int>>& edges, bool addOuterFace=true) {
+    const HalfEdgeMesh& mesh, bool addOuterFace=true) {
 
     vector<vector<int>> faces;
     vector<pair<int,int>> faceEdges;
-    vector<pair<int,int>> edgePos(edges.size());
-    vector<vector<pair<int,int>>> graph(n);
-    vector<vector<bool>> visited(n);
-    vector<vector<int>> whichFace(n);
+    vector<int> whichFace(mesh.size(), -1);
 
-    for (int i = 0; i < edges.size(); ++i) {
-        graph[edges[i].first].push_back({edges[i].second, i});
-        graph[edges[i].second].push_back({edges[i].first, i});
+    if (!addOuterFace && mesh.outer != -1) {
+        int e = mesh.outer;
+        do {
+            whichFace[e] = -2;
+            e = mesh.next[e];
+        } while (e != mesh.outer);
     }
 
-    for(int node = 0; node < n; ++node) {
-
-        // Rewrite this function.
-        auto cmp = [&] (pair<int,int> a, pair<int,int> b) {
-            if (a.first < node)
-                a.first += n;
-            if (b.first < node)
-                b.first += n;
-            return a.first < b.first;
-        };
-        sort(graph[node].begin(), graph[node].end(), cmp);
-        for (int i = 0; i < graph[node].size(); ++i) {
-            int edgeIndex = graph[node][i].second;
-            if (edges[edgeIndex].first == node)
-                edgePos[edgeIndex].first = i;
-            else edgePos[edgeIndex].second = i;
-        }
-        visited[node].resize(graph[node].size());
-        whichFace[node].resize(graph[node].size());
+    for (int start = 0; start < mesh.size(); ++start) {
+        if (whichFace[start] != -1)
+            continue;
+        vector<int> faceVertices;
+        int e = start;
+        do {
+            faceVertices.push_back(mesh.origin[e]);
+            whichFace[e] = faces.size();
+            e = mesh.next[e];
+        } while (e != start);
+        faces.push_back(faceVertices);
     }
 
+    for (int e = 0; e < mesh.size(); ++e) {
+        int f = whichFace[e], g = whichFace[mesh.twin[e]];
+        if (f >= 0 && g >= 0)
+            faceEdges.push_back({f, g});
+    }
 
-    auto getCorrespondent = [&](int x, int ind) {
-        int edgeIndex = graph[x][ind].second;
-        if (x == edges[edgeIndex].first) {
-            return make_pair(edges[edgeIndex].second, edgePos[edgeIndex].second);
-        } else {
-            return make_pair(edges[edgeIndex].first, edgePos[edgeIndex].first);
-        }
-    };
+    return {faces, faceEdges};
+}
 
-    for (int node = 0; node < n; ++node) {
-        for (int i = 0; i < graph[node].size(); ++i) {
-            if (i != graph[node].size() - 1 || addOuterFace) {
-                if (!visited[node][i]) {
-                    vector<int> faceVertices;
+// Half-edges of a planar graph drawn with straight edges between points.
+// Edge i gives half-edges 2i (first -> second) and 2i+1, the outgoing
+// half-edges of every vertex are stored contiguously (CSR) in exact angular
+// order, and next follows the face on the left. outer is set for the
+// component of the lowest-leftmost vertex.
+template<typename T>
+HalfEdgeMesh buildHalfEdges(const vector<Point<T>>& points, const vector<pair<int,int>>& edges) {
+    int n = points.size(), m = 2 * edges.size();
+    HalfEdgeMesh mesh;
+    mesh.vertices = n;
+    mesh.origin.resize(m);
+    mesh.twin.resize(m);
+    mesh.next.resize(m);
+    for (int i = 0; i < edges.size(); ++i) {
+        mesh.origin[2*i] = edges[i].first;
+        mesh.origin[2*i+1] = edges[i].second;
+        mesh.twin[2*i] = 2*i+1;
+        mesh.twin[2*i+1] = 2*i;
+    }
 
-                    int x = node;
-                    int ind = i;
+    vector<int> start(n + 1, 0), out(m), pos(m);
+    for (int e = 0; e < m; ++e) {
+        ++start[mesh.origin[e] + 1];
+    }
+    partial_sum(start.begin(), start.end(), start.begin());
+    vector<int> slot(start.begin(), start.end() - 1);
+    for (int e = 0; e < m; ++e) {
+        out[slot[mesh.origin[e]]++] = e;
+    }
 
-                    while (!visited[x][ind]) {
-                        faceVertices.push_back(x);
-                        visited[x][ind] = true;
-                        whichFace[x][ind] = faces.size();
-                        tie(x, ind) = getCorrespondent(x, ind);
-                        ind = (ind - 1 + graph[x].size()) % graph[x].size();
-                    }
+    auto direction = [&](int e) {
+        return points[mesh.origin[mesh.twin[e]]] - points[mesh.origin[e]];
+    };
+    for (int v = 0; v < n; ++v) {
+        sort(out.begin() + start[v], out.begin() + start[v+1], [&](int a, int b) {
+            return AngleLess(direction(a), direction(b));
+        });
+        for (int i = start[v]; i < start[v+1]; ++i) {
+            pos[out[i]] = i;
+        }
+    }
 
-                    faces.push_back(faceVertices);
-                }
+    // Around the face on the left of u -> v, the next half-edge leaves v
+    // just clockwise of v -> u.
+    for (int e = 0; e < m; ++e) {
+        int t = mesh.twin[e], v = mesh.origin[t];
+        int i = pos[t] == start[v] ? start[v+1] - 1 : pos[t] - 1;
+        mesh.next[e] = out[i];
+    }
 
-                if (i != 0) {
-                    faceEdges.push_back({whichFace[node][i], whichFace[node][i-1]});
-                }
-            }
-        }
-        if (addOuterFace) {
-            faceEdges.push_back({whichFace[node][0], whichFace[node][graph[node].size()-1]});
+    // The outer face touches the lowest-leftmost vertex from the left, so it
+    // follows its last outgoing half-edge pointing up, or its last one.
+    int low = -1;
+    for (int v = 0; v < n; ++v) {
+        if (start[v] < start[v+1] && (low == -1 ||
+            tie(points[v].x, points[v].y) < tie(points[low].x, points[low].y)))
+            low = v;
+    }
+    if (low != -1) {
+        mesh.outer = out[start[low+1] - 1];
+        for (int i = start[low]; i < start[low+1]; ++i) {
+            Point<T> d = direction(out[i]);
+            if (d.y > 0 || (d.y == 0 && d.x > 0))
+                mesh.outer = out[i];
         }
     }
+    return mesh;
+}
 
-    return {faces, faceEdges};
+// Constructs the dual of a connected planar graph whose vertices are the
+// given points, with straight edges. Neighbours are ordered by exact angle.
+template<typename T>
+pair<vector<vector<int>>, vector<pair<int,int>>> buildDual(
+    const vector<Point<T>>& points, const vector<pair<int,int>>& edges, bool addOuterFace=true) {
+    return buildDual(buildHalfEdges(points, edges), addOuterFace);
 }
@@ -2,220 +2,660 @@
 #include <vector>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <mutex>
 
 using namespace std;
 
+typedef unsigned long long uint64;
+typedef unsigned __int128 uint128;
+
+// Number theoretic transform modulo three primes, recombined with Garner's
+// algorithm like MultiModConvolution in fft.cpp. The primes multiply to
+// more than 2^92, so convolutions of values below 2^32 are exact for
+// operands of up to 2^24 elements.
+namespace ntt {
+
+template<uint32_t M>
+uint64_t Power(uint64_t x, uint64_t pw) {
+    uint64_t r = 1;
+    for (x %= M; pw; pw >>= 1, x = x * x % M) {
+        if (pw & 1) {
+            r = r * x % M;
+        }
+    }
+    return r;
+}
+
+template<uint32_t M, uint32_t G>
+void Transform(vector<uint32_t>& a, bool invert) {
+    int n = a.size();
+    for (int i = 1, j = 0; i < n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            swap(a[i], a[j]);
+        }
+    }
+    vector<uint32_t> w(max(1, n / 2));
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len / 2;
+        uint64_t root = Power<M>(G, (M - 1) / len);
+        if (invert) {
+            root = Power<M>(root, M - 2);
+        }
+        w[0] = 1;
+        for (int i = 1; i < half; ++i) {
+            w[i] = w[i-1] * root % M;
+        }
+        for (int i = 0; i < n; i += len) {
+            for (int j = 0; j < half; ++j) {
+                uint32_t x = a[i+j];
+                uint32_t y = (uint64_t)a[i+j+half] * w[j] % M;
+                a[i+j] = x + y >= M ? x + y - M : x + y;
+                a[i+j+half] = x >= y ? x - y : x + M - y;
+            }
+        }
+    }
+    if (invert) {
+        uint64_t inv = Power<M>(n, M - 2);
+        for (auto& x : a) {
+            x = x * inv % M;
+        }
+    }
+}
+
+template<uint32_t M, uint32_t G>
+vector<uint32_t> Convolve(const vector<uint32_t>& a, const vector<uint32_t>& b, int n) {
+    vector<uint32_t> fa(n), fb(n);
+    for (size_t i = 0; i < a.size(); ++i) {
+        fa[i] = a[i] % M;
+    }
+    for (size_t i = 0; i < b.size(); ++i) {
+        fb[i] = b[i] % M;
+    }
+    Transform<M, G>(fa, false);
+    Transform<M, G>(fb, false);
+    for (int i = 0; i < n; ++i) {
+        fa[i] = (uint64_t)fa[i] * fb[i] % M;
+    }
+    Transform<M, G>(fa, true);
+    fa.resize(a.size() + b.size() - 1);
+    return fa;
+}
+
+// The exact convolution of a and b.
+vector<uint128> Convolve(const vector<uint32_t>& a, const vector<uint32_t>& b) {
+    const uint32_t p1 = 2013265921, p2 = 1811939329, p3 = 2113929217;
+    int n = 1;
+    while (n < (int)(a.size() + b.size())) {
+        n <<= 1;
+    }
+    auto r1 = Convolve<p1, 31>(a, b, n);
+    auto r2 = Convolve<p2, 13>(a, b, n);
+    auto r3 = Convolve<p3, 5>(a, b, n);
+    const uint64_t inv1 = Power<p2>(p1, p2 - 2);
+    const uint64_t inv12 = Power<p3>((uint64_t)p1 * p2 % p3, p3 - 2);
+    vector<uint128> result(r1.size());
+    for (size_t i = 0; i < r1.size(); ++i) {
+        uint64_t k1 = (r2[i] + p2 - r1[i] % p2) * inv1 % p2;
+        uint64_t low = r1[i] + (uint64_t)p1 * k1;
+        uint64_t k2 = (r3[i] + p3 - low % p3) * inv12 % p3;
+        result[i] = low + (uint128)((uint64_t)p1 * p2) * k2;
+    }
+    return result;
+}
+
+}  // namespace ntt
+
+// Non-negative fixed point numbers. The limbs v, in base 2^64, hold the
+// value times 2^(64 * point). Multiplication uses the kernels of Huge in
+// huge.cpp: schoolbook, Karatsuba and a three-prime NTT by operand size.
 class BigNum {
-    int v[3500];
-    int sz;
+    static const int kKaratsubaLimbs = 32;
+    static const int kNttLimbs = 2048;
+    vector<uint64> v;
+    int point = 0;
 
-  public:
-    static const int base = (1<<30);
+    static void Trim(vector<uint64>& a) {
+        while (!a.empty() && a.back() == 0) {
+            a.pop_back();
+        }
+    }
+
+    // a += b * 2^(64 * shift).
+    static void AddShifted(vector<uint64>& a, const vector<uint64>& b, int shift) {
+        if (a.size() < b.size() + shift) {
+            a.resize(b.size() + shift);
+        }
+        uint64 carry = 0;
+        for (size_t i = 0; i < b.size() || carry; ++i) {
+            if (shift + i == a.size()) {
+                a.push_back(0);
+            }
+            uint128 s = (uint128)a[shift+i] + (i < b.size() ? b[i] : 0) + carry;
+            a[shift+i] = (uint64)s;
+            carry = s >> 64;
+        }
+    }
+
+    // a -= b and returns the final borrow, which is set if a < b.
+    static bool Subtract(vector<uint64>& a, const vector<uint64>& b) {
+        uint64 borrow = 0;
+        size_t i = 0;
+        for (; i < b.size() || (i < a.size() && borrow); ++i) {
+            uint128 d = (uint128)a[i] - (i < b.size() ? b[i] : 0) - borrow;
+            a[i] = (uint64)d;
+            borrow = (uint64)(d >> 64) != 0;
+        }
+        Trim(a);
+        return borrow;
+    }
+
+    static vector<uint64> MultiplySchool(const vector<uint64>& a, const vector<uint64>& b) {
+        if (a.empty() || b.empty()) {
+            return {};
+        }
+        int n = a.size(), m = b.size();
+        vector<uint64> result(n + m);
+        for (int i = 0; i < n; ++i) {
+            uint64 carry = 0;
+            for (int j = 0; j < m; ++j) {
+                uint128 t = (uint128)a[i] * b[j] + result[i+j] + carry;
+                result[i+j] = (uint64)t;
+                carry = t >> 64;
+            }
+            result[i+m] = carry;
+        }
+        Trim(result);
+        return result;
+    }
+
+    static vector<uint64> MultiplyKaratsuba(const vector<uint64>& a, const vector<uint64>& b) {
+        int n = a.size(), m = b.size();
+        if (n < m) {
+            return MultiplyKaratsuba(b, a);
+        }
+        if (m < kKaratsubaLimbs) {
+            return MultiplySchool(a, b);
+        }
+        if (n >= 2 * m) {
+            // Unbalanced: multiply b by slices of a of its own length.
+            vector<uint64> result;
+            for (int i = 0; i < n; i += m) {
+                vector<uint64> slice(a.begin() + i, a.begin() + min(n, i + m));
+                Trim(slice);
+                AddShifted(result, MultiplyKaratsuba(slice, b), i);
+            }
+            Trim(result);
+            return result;
+        }
+        int h = n / 2;
+        vector<uint64> a0(a.begin(), a.begin() + h), a1(a.begin() + h, a.end());
+        vector<uint64> b0(b.begin(), b.begin() + h), b1(b.begin() + h, b.end());
+        Trim(a0);
+        Trim(b0);
+        auto z0 = MultiplyKaratsuba(a0, b0);
+        auto z2 = MultiplyKaratsuba(a1, b1);
+        AddShifted(a0, a1, 0);
+        AddShifted(b0, b1, 0);
+        auto z1 = MultiplyKaratsuba(a0, b0);
+        Subtract(z1, z0);
+        Subtract(z1, z2);
+        AddShifted(z0, z1, h);
+        AddShifted(z0, z2, 2 * h);
+        Trim(z0);
+        return z0;
+    }
+
+    // Splits the limbs into 32-bit digits, so the convolution stays within
+    // the range of the NTT.
+    static vector<uint64> MultiplyNtt(const vector<uint64>& a, const vector<uint64>& b) {
+        auto split = [](const vector<uint64>& a) {
+            vector<uint32_t> digits(2 * a.size());
+            for (size_t i = 0; i < a.size(); ++i) {
+                digits[2*i] = (uint32_t)a[i];
+                digits[2*i+1] = a[i] >> 32;
+            }
+            return digits;
+        };
+        auto c = ntt::Convolve(split(a), split(b));
+        vector<uint64> result(c.size() / 2 + 2);
+        uint128 carry = 0;
+        for (size_t i = 0; i < c.size() || carry; ++i) {
+            uint128 cur = carry + (i < c.size() ? c[i] : 0);
+            result[i/2] |= (uint64)(uint32_t)cur << (i % 2 * 32);
+            carry = cur >> 32;
+        }
+        Trim(result);
+        return result;
+    }
+
+    static vector<uint64> Multiply(const vector<uint64>& a, const vector<uint64>& b) {
+        if (min(a.size(), b.size()) < (size_t)kKaratsubaLimbs) {
+            return MultiplySchool(a, b);
+        }
+        if (min(a.size(), b.size()) < (size_t)kNttLimbs) {
+            return MultiplyKaratsuba(a, b);
+        }
+        return MultiplyNtt(a, b);
+    }
 
+
+  public:
     int size() const {
-        return sz;
+        return (int)v.size();
     }
 
-    BigNum () : sz(0) {}
+    // The number of fractional limbs.
+    int precision() const {
+        return point;
+    }
+
+    BigNum() {}
 
     BigNum(long long c) {
-        sz = 0;
         complete(c);
     }
 
-    void complete(long long c) {
-        while (c) {
-            v[sz++] = (c%base);
-            c /= base;
+    // Builds x, which must be non-negative, to `precision` fractional limbs.
+    static BigNum from_long_double(long double x, int precision) {
+        BigNum result;
+        result.point = precision;
+        result.v.resize(precision + 1);
+        result.v[precision] = (uint64)floorl(x);
+        for (int i = precision - 1; i >= 0; --i) {
+            x = ldexpl(x - floorl(x), 64);
+            result.v[i] = (uint64)floorl(x);
         }
+        Trim(result.v);
+        return result;
     }
 
-    void resize(int new_sz) {
-        new_sz = max(new_sz, 0);
-        if (new_sz < sz) {
-            for (int i = sz-1; i >= new_sz; --i)
-                v[i] = 0;
-        } else {
-            for (int i = sz; i < new_sz; ++i)
-                v[i] = 0;
+    void complete(uint64 c) {
+        if (c) {
+            v.push_back(c);
         }
-        sz = new_sz;
     }
 
-    int& operator [] (int x) {
+    void resize(int new_sz) {
+        v.resize(max(new_sz, 0));
+    }
+
+    uint64& operator [] (int x) {
         return v[x];
     }
 
-    int operator [] (int x) const {
+    uint64 operator [] (int x) const {
         return v[x];
     }
 
-    void operator = (const BigNum& other) {
-        for (int i = 0; i < other.sz; ++i) {
-            v[i] = other.v[i];
+    // Rounds towards zero to the given number of fractional limbs, or pads
+    // with zero limbs.
+    void set_precision(int p) {
+        if (p < point) {
+            v.erase(v.begin(), v.begin() + min(size(), point - p));
+        } else if (!v.empty()) {
+            v.insert(v.begin(), p - point, 0);
+        }
+        point = p;
+    }
+
+    // The value as a long double, from its two leading limbs.
+    long double to_long_double() const {
+        long double r = 0;
+        for (int i = size() - 1; i >= max(0, size() - 2); --i) {
+            r = ldexpl(r, 64) + v[i];
+        }
+        return ldexpl(r, 64 * (max(0, size() - 2) - point));
+    }
+
+    int compare(const BigNum& other) const {
+        // Align both to the larger precision without copying.
+        int shift = max(point, other.point);
+        int a = shift - point, b = shift - other.point;
+        int sa = size() + a, sb = other.size() + b;
+        if (sa != sb) {
+            return sa < sb ? -1 : 1;
+        }
+        for (int i = sa - 1; i >= 0; --i) {
+            uint64 x = i >= a ? v[i-a] : 0, y = i >= b ? other.v[i-b] : 0;
+            if (x != y) {
+                return x < y ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+
+    bool operator <= (const BigNum& other) const {
+        return compare(other) <= 0;
+    }
+
+    bool operator > (const BigNum& other) const {
+        return compare(other) > 0;
+    }
+
+    BigNum& operator += (const BigNum& other) {
+        if (point < other.point) {
+            set_precision(other.point);
+        }
+        AddShifted(v, other.v, point - other.point);
+        return *this;
+    }
+
+    // For other <= *this.
+    BigNum& operator -= (const BigNum& other) {
+        if (point < other.point) {
+            set_precision(other.point);
+        }
+        if (point == other.point) {
+            Subtract(v, other.v);
+        } else {
+            BigNum aligned = other;
+            aligned.set_precision(point);
+            Subtract(v, aligned.v);
         }
-        sz = other.sz;
+        return *this;
+    }
+
+    BigNum operator * (const BigNum& other) const {
+        BigNum result;
+        result.v = Multiply(v, other.v);
+        result.point = point + other.point;
+        return result;
     }
 
-    void operator *= (long long c) {
-        int t = 0;
-        for (int i = 0; i < sz; ++i) {
-            long long x = v[i] * c + t;
-            t = (x>>30);
-            v[i] = (x&(base-1));
+    void operator *= (uint64 c) {
+        uint64 t = 0;
+        for (int i = 0; i < size(); ++i) {
+            uint128 x = (uint128)v[i] * c + t;
+            t = x >> 64;
+            v[i] = (uint64)x;
         }
         complete(t);
     }
 
-    int operator /= (int div) {
-        long long rem = 0;
-        for (int i = sz-1; i >= 0; --i) {
-            rem = (rem<<30) + v[i];
+    uint64 operator /= (uint64 div) {
+        uint128 rem = 0;
+        for (int i = size() - 1; i >= 0; --i) {
+            rem = rem << 64 | v[i];
             v[i] = rem / div;
             rem %= div;
         }
-        while (sz > 0 && v[sz-1] == 0)
-            --sz;
+        Trim(v);
         return rem;
     }
 
-    void operator += (const BigNum& other) {
-        while (sz < other.sz)
-            v[sz++] = 0;
-        int t = 0;
-        int i;
-        for (i = 0; i < other.sz || t; ++i) {
-            v[i] += t + (i < other.sz ? other.v[i] : 0);
-            t = (v[i]>>30);
-            v[i] &= (base-1);
+    // Multiplies by 2^(64 * c), moving the point first.
+    void operator <<= (int c) {
+        if (c > point) {
+            v.insert(v.begin(), c - point, 0);
+            c = point;
         }
+        point -= c;
+        Trim(v);
     }
 
-    void operator <<= (int c) {
-        for (int i = sz-1; i >= 0; --i) {
-            v[i+c] = v[i];
-        }
-        for (int i = 0; i < c; ++i)
-            v[i] = 0;
-        sz += c;
-    }
-
-    bool less_than_or_equal_to_with_left_shift(const BigNum& other, int shift) {
-        int st = max(sz, other.sz + shift);
-        for (int i = st-1; i >= 0; --i) {
-            int c1 = (i < sz ? v[i] : 0);
-            int c2 = (i - shift >= 0 && i - shift < other.sz ? other.v[i-shift] : 0);
-            if (c1 < c2) {
-                return true;
-            } else if (c1 > c2) {
-                return false;
-            }
-        }
-        return true;
+    // Divides by 2^(64 * c) exactly.
+    void operator >>= (int c) {
+        point += c;
     }
 };
 
 int n, k;
 
-void split(const BigNum& a, BigNum& left, BigNum& right, int leftsize) {
-    left.resize(leftsize);
-    for (int i = 0; i < leftsize; ++i) {
-        left[i] = a[i];
+// Decimal conversion splits numbers by powers 10^(9 * 2^j) down to
+// 2^kDecimalLevel chunks of 9 digits, converting the halves of numbers with
+// at least kParallelLimbs limbs on separate threads. Conversions may run
+// on several threads at once; the powers of ten they share are cached
+// under a lock, up to kDecimalLevels levels.
+const int kDecimalLevel = 4;
+const int kParallelLimbs = 2048;
+const int kDecimalLevels = 48;
+
+BigNum Inverse(const BigNum& x, int precision);
+
+// 10^(9 * 2^j), cached. Missing levels are filled in under a lock and
+// published through ready; a filled level never changes, so any thread
+// may call it and keep the reference.
+const BigNum& power_of_ten(int j) {
+    static BigNum powers[kDecimalLevels];
+    static atomic<int> ready(0);
+    static mutex lock;
+    if (j >= ready.load(memory_order_acquire)) {
+        lock_guard<mutex> guard(lock);
+        for (int i = ready.load(memory_order_relaxed); i <= j; ++i) {
+            powers[i] = i ? powers[i - 1] * powers[i - 1] : BigNum(1000000000);
+            ready.store(i + 1, memory_order_release);
+        }
     }
-    right.resize(a.size() - leftsize);
-    for (int i = leftsize; i < a.size(); ++i) {
-        right[i-leftsize] = a[i];
+    return powers[j];
+}
+
+// 1 / power_of_ten(j), precise enough that the quotient of anything below
+// power_of_ten(j + 1) is off by at most a few units. Cached the same way
+// as power_of_ten.
+const BigNum& inverse_power_of_ten(int j) {
+    static BigNum inverses[kDecimalLevels];
+    static atomic<int> ready(0);
+    static mutex lock;
+    if (j >= ready.load(memory_order_acquire)) {
+        lock_guard<mutex> guard(lock);
+        for (int i = ready.load(memory_order_relaxed); i <= j; ++i) {
+            BigNum x = power_of_ten(i);
+            int shift = x.size() - 1;
+            x >>= shift;
+            BigNum y = Inverse(x, shift + 4);
+            y >>= shift;
+            inverses[i] = y;
+            ready.store(i + 1, memory_order_release);
+        }
     }
+    return inverses[j];
 }
 
-string to_str(int x) {
-    string s;
-    for (int i = 0; i < 9; ++i) {
-        s += (char)(x%10 + '0');
-        x /= 10;
+// Writes the integer x < power_of_ten(j) to out as exactly 9 * 2^j digits.
+void write_decimal(const BigNum& x, int j, char* out, int threads) {
+    if (j <= kDecimalLevel) {
+        BigNum y = x;
+        for (char* end = out + (9 << j); end > out; end -= 9) {
+            uint64 chunk = (y /= 1000000000);
+            for (int i = 1; i <= 9; ++i, chunk /= 10) {
+                end[-i] = (char)(chunk % 10 + '0');
+            }
+        }
+        return;
+    }
+    const BigNum& p = power_of_ten(j - 1);
+    BigNum q = x * inverse_power_of_ten(j - 1);
+    q.set_precision(0);
+    BigNum qp = q * p, one(1);
+    while (qp > x) {
+        q -= one;
+        qp -= p;
+    }
+    BigNum r = x;
+    r -= qp;
+    while (p <= r) {
+        q += one;
+        r -= p;
+    }
+    char* low = out + (9 << (j - 1));
+    if (threads > 1 && x.size() >= kParallelLimbs) {
+        thread high([&] { write_decimal(q, j - 1, out, threads / 2); });
+        write_decimal(r, j - 1, low, threads - threads / 2);
+        high.join();
+    } else {
+        write_decimal(q, j - 1, out, 1);
+        write_decimal(r, j - 1, low, 1);
     }
-    return s;
 }
 
-int leading_zeroes(const string& repr) {
-    int i = 0;
-    while (i < repr.size() && repr[i] == '0')
-        ++i;
-    if (i == repr.size())
-        return i-1;
-    else return i;
+// The smallest level whose width holds `digits` digits, with the caches
+// filled up to it so that write_decimal's threads only read them.
+int decimal_level(int digits) {
+    int j = 0;
+    while ((9 << j) < digits) {
+        ++j;
+    }
+    if (j > 0) {
+        inverse_power_of_ten(j - 1);
+    }
+    power_of_ten(j);
+    return j;
 }
 
-string base_10_representation(BigNum x, int digits_after_decimal, int wanted_digits_after_decimal) {
-    BigNum a, b;
-    split(x, a, b, digits_after_decimal);
-
-    int new_base = 1e9;
-
-    string before_decimal;
-    while (b.size() > 0) {
-        int rem = (b /= new_base);
-        string s = to_str(rem);
-        before_decimal += s;
-    }
-    reverse(before_decimal.begin(), before_decimal.end());
-    int num_zeroes = leading_zeroes(before_decimal);
-    before_decimal.erase(0, num_zeroes);
-
-    string after_decimal;
-    for (int i = 0; i < digits_after_decimal; ++i) {
-        a.resize(a.size() + 1);
-        a *= new_base;
-        int x = a[a.size() - 1];
-        a.resize(a.size()- 1);
-        string s = to_str(x);
-        reverse(s.begin(), s.end());
-        after_decimal += s;
-    }
-    while (after_decimal.size() > wanted_digits_after_decimal)
-        after_decimal.pop_back();
-    return before_decimal + "." + after_decimal;
+// Writes the integer part of x and the first wanted_digits_after_decimal
+// digits of its fraction, both truncated, straight into the result. The
+// fraction digits are floor(fraction * 10^wanted), converted like an
+// integer.
+string base_10_representation(const BigNum& x, int wanted_digits_after_decimal,
+                              int threads = max(1u, thread::hardware_concurrency())) {
+    BigNum b = x;
+    b.set_precision(0);
+    BigNum a = x;
+    a -= b;
+
+    // b < 2^(64 * size) has at most this many digits.
+    int j = decimal_level((int)(b.size() * 64 * log10(2.0)) + 1);
+    string result(9 << j, '0');
+    write_decimal(b, j, &result[0], threads);
+    result.erase(0, min(result.find_first_not_of('0'), result.size() - 1));
+    result += '.';
+
+    int wanted = wanted_digits_after_decimal;
+    BigNum scale(1);
+    for (int i = 0; i < wanted % 9; ++i) {
+        scale *= 10;
+    }
+    for (int i = 0; (9 << i) <= wanted; ++i) {
+        if (wanted / 9 >> i & 1) {
+            scale = scale * power_of_ten(i);
+        }
+    }
+    a = a * scale;
+    a.set_precision(0);
+    j = decimal_level(wanted);
+    size_t start = result.size();
+    result.resize(start + (9 << j));
+    write_decimal(a, j, &result[start], threads);
+    result.erase(start, (9 << j) - wanted);
+    return result;
+}
+
+// 1 / x to about `precision` fractional limbs, for x in [1, 2^64), by
+// Newton steps y += y * (1 - x * y) that double the precision.
+BigNum Inverse(const BigNum& x, int precision) {
+    if (precision <= 2) {
+        return BigNum::from_long_double(1 / x.to_long_double(), precision);
+    }
+    BigNum y = Inverse(x, precision / 2 + 1);
+    y.set_precision(precision);
+    BigNum xt = x;
+    xt.set_precision(precision);
+    BigNum t = xt * y;
+    t.set_precision(precision);
+    BigNum one(1);
+    bool below = t <= one;
+    BigNum e = below ? one : t;
+    e -= below ? t : one;
+    BigNum d = y * e;
+    d.set_precision(precision);
+    if (below) {
+        y += d;
+    } else {
+        y -= d;
+    }
+    return y;
+}
+
+// 1 / sqrt(x) to about `precision` fractional limbs, for x in
+// [2^-64, 2^64). The estimate for half the precision is refined by one
+// Newton step y += y * (1 - x * y^2) / 2, so the precision doubles each
+// step and the total cost is a few multiplications at full size.
+BigNum InverseSqrt(const BigNum& x, int precision) {
+    if (precision <= 2) {
+        return BigNum::from_long_double(1 / sqrtl(x.to_long_double()), precision);
+    }
+    BigNum y = InverseSqrt(x, precision / 2 + 1);
+    y.set_precision(precision);
+    BigNum xt = x;
+    xt.set_precision(precision);
+    BigNum t = xt * y;
+    t.set_precision(precision);
+    t = t * y;
+    t.set_precision(precision);
+    BigNum one(1);
+    bool below = t <= one;
+    BigNum e = below ? one : t;
+    e -= below ? t : one;
+    BigNum d = y * e;
+    d.set_precision(precision);
+    d /= 2;
+    if (below) {
+        y += d;
+    } else {
+        y -= d;
+    }
+    return y;
 }
 
 string Sqrt(BigNum N, int k) {
-    if (N.size() % 2 == 1) {
-        N.resize(N.size() + 1);
-    }
-
-    int logbase = log10(N.base);
-
-    int digits_before_decimal = N.size()/2;
-    int digits_after_decimal = k / logbase + 1;
-    int total_digits = digits_before_decimal + digits_after_decimal;
-
-    BigNum ans(0), square(0);
-    // Binary search each digit of the result.
-    // Use the fact that (x * 10 + d)^2 = x^2 * 100 + 2 * d * x + d^2.
-    for (int i = 0; i < total_digits; ++i) {
-        long long lo = 0, hi = N.base;
-        ans <<= 1;
-        square <<= 2;
-        while (hi - lo > 1) {
-            long long mid = (lo + hi)>>1;
-            BigNum current_square = square;
-            BigNum add = ans;
-            add *= 2*mid;
-            current_square += add;
-            current_square += mid * mid;
-            if (current_square.less_than_or_equal_to_with_left_shift(N, 2*i)) {
-                lo = mid;
-            } else {
-                hi = mid;
-            }
-        }
-        BigNum add = ans;
-        add *= 2*lo;
-        square += add;
-        square += lo * lo;
-        ans[0] = lo;
+    if (N.size() == 0) {
+        return base_10_representation(N, k);
+    }
+    // N = x * 2^(128 * h) with x in [2^-64, 2^64).
+    int h = N.size() / 2;
+    BigNum x = N;
+    x >>= 2 * h;
+
+    int digits_after_decimal = (int)(k * log2(10.0) / 64) + 2;
+    int precision = digits_after_decimal + h + 3;
+
+    // sqrt(x) = x / sqrt(x), with one more Newton step
+    // s += y * (x - s^2) / 2 for the bits lost in the product.
+    BigNum y = InverseSqrt(x, precision);
+    x.set_precision(precision);
+    BigNum s = x * y;
+    s.set_precision(precision);
+    BigNum sq = s * s;
+    bool below = sq <= x;
+    BigNum e = below ? x : sq;
+    e -= below ? sq : x;
+    BigNum d = y * e;
+    d.set_precision(precision);
+    d /= 2;
+    if (below) {
+        s += d;
+    } else {
+        s -= d;
+    }
+
+    // sqrt(N) = s * 2^(64 * h), truncated and then corrected to the exact
+    // floor at this precision.
+    BigNum ans = s;
+    ans <<= h;
+    ans.set_precision(digits_after_decimal);
+    BigNum ulp(1);
+    ulp >>= digits_after_decimal;
+    while (ans * ans > N) {
+        ans -= ulp;
+    }
+    BigNum next = ans;
+    next += ulp;
+    while (next * next <= N) {
+        ans = next;
+        next += ulp;
     }
 
-    return base_10_representation(ans, digits_after_decimal, k);
+    return base_10_representation(ans, k);
 }
 
 int main()
@@ -1,5 +1,5 @@
 #include <iostream>
-#include <cstdlib>
+#include <cstdint>
 #include <functional>
 #include <fstream>
 
@@ -10,18 +10,33 @@ using namespace std;
 // TODO: Better Iterator.
 namespace treap {
 
-int myRand() {
-    return ((rand()&((1<<15)-1))<<15) + (rand()&((1<<15)-1));
-}
+// Default source of node priorities.
+// Every Treap owns its own generator, so two treaps never share state
+// and the same seed always builds the same tree.
+// Any type with a uint64_t operator () () can be plugged in instead.
+class SplitMix64 {
+    uint64_t state;
+
+  public:
+    SplitMix64(uint64_t seed=0x9E3779B97F4A7C15ULL) : state(seed) {}
+
+    uint64_t operator () () {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
 
 template<typename T>
 struct Node {
     T val;
-    int prio, sub;
+    uint64_t prio;
+    int sub;
     bool sw;
     Node *left, *right, *father;
  
-    Node(const T& val) : val(val), prio(myRand()), sub(1), sw(false), 
+    Node(const T& val, uint64_t prio) : val(val), prio(prio), sub(1), sw(false), 
     left(NULL), right(NULL), father(NULL)   {}
  
     int leftSize() const {
@@ -117,11 +132,12 @@ class Iterator {
     }
 };
 
-template<typename T>
+template<typename T, typename Rng=SplitMix64>
 class Treap {
     Node<T>* root;
     int sz;
     int aux;
+    Rng rng;
      
     // First k-1 nodes in L, everything else in R.
     void splitAtKth(Node<T>* C, Node<T>*& L, Node<T>*& R, int k) {
@@ -309,7 +325,7 @@ class Treap {
 
   public:
 
-    Treap() : root(NULL), sz(0) {}
+    Treap(const Rng& rng=Rng()) : root(NULL), sz(0), rng(rng) {}
 
     void destroy(Node<T>* N) {
         if (N == NULL)
@@ -325,7 +341,7 @@ class Treap {
 
     // Force insert at position k.
     void insertAt(int k, const T& val) {
-        Node<T> *N = new Node<T>(val);
+        Node<T> *N = new Node<T>(val, rng());
         insertAtKth(root, N, k);
         ++sz;
     }
@@ -333,7 +349,7 @@ class Treap {
     // Insert by using comparisons.
     // Needs operator <= defined on T.
     void insert(const T& val) {
-        Node<T> *N = new Node<T>(val);
+        Node<T> *N = new Node<T>(val, rng());
         insertByComparison(root, N);
         ++sz;
     }